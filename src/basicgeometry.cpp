@@ -0,0 +1,114 @@
+#include "basicgeometry.h"
+#include "geometry.h"
+#include "polygonsearch.h"
+#include <algorithm>
+
+using namespace std;
+
+template <class T> BasicPolygon <T>::BasicPolygon(const vector <BasicPoint <T> > &p) : points(p)
+{
+    if (points.size() >= 3 && (points[2] - points[0]) % (points[1] - points[0]) > 0)
+        reverse(points.begin(), points.end());
+    upmost = downmost = 0;
+    for (int i = 0; i < (int) points.size(); i++)
+    {
+        if (points[i].y > points[upmost].y || (points[i].y == points[upmost].y && points[i].x > points[upmost].x))
+            upmost = i;
+        if (points[i].y < points[downmost].y || (points[i].y == points[downmost].y && points[i].x > points[downmost].x))
+            downmost = i;
+    }
+}
+
+template <class T> inline bool isOnSegment(const BasicPoint <T> &a, const BasicPoint <T> &from, const BasicPoint <T> &to)
+{
+    return (a - from) % (to - from) == 0 && (a - from) * (to - from) >= 0 && (a - to) * (from - to) >= 0;
+}
+
+template <class T> bool isInsideHalfPlanes(const BasicPoint <T> &point, const BasicPolygon <T> &poly)
+{
+    // Polygon is convex, so point is inside iff it is not to the right of any side
+    const BasicPoint <T> *p = poly.data();
+    int n = poly.size();
+    bool outside = (poly[0] - p[n - 1]) % (point - p[n - 1]) < 0;
+    for (int i = 0; i + 1 < n; i++)
+        outside |= (p[i + 1] - p[i]) % (point - p[i]) < 0;
+    return !outside;
+}
+
+template <class T> bool isInside(const BasicPoint <T> &point, const BasicPolygon <T> &poly)
+{
+    StatsScope stats(STATS_IS_INSIDE, poly.size(), 0);
+    NullTracer tracer;
+    int l = fanSearch(0, poly.size(), [&poly, point](int m)
+    {
+        return (point - poly[0]) % (poly[m] - poly[0]);
+    },
+    [](int, int, int) {}, [](int) {}, stats, tracer);
+    if (l == poly.size() - 1)
+        return isOnSegment(point, poly[l], poly[0]);
+    return (point - poly[0]) % (poly[l] - poly[0]) <= 0 &&
+           (point - poly[l]) % (poly[l + 1] - poly[l]) <= 0 &&
+           (point - poly[l + 1]) % (poly[0] - poly[l + 1]) <= 0;
+}
+
+template <class T> int leftTangent(const BasicPoint <T> &point, const BasicPolygon <T> &poly)
+{
+    StatsScope stats(STATS_LEFT_TANGENT, poly.size(), 2);
+    NullTracer tracer;
+    return leftTangentSearch(poly.size(), [&poly, point](int i)
+    {
+        return poly[i] - point;
+    },
+    [](const BasicPoint <T> &a, const BasicPoint <T> &b)
+    {
+        return a % b;
+    },
+    [](int, int, int, int, int) {}, stats, tracer);
+}
+
+template <class T> int rightTangent(const BasicPoint <T> &point, const BasicPolygon <T> &poly)
+{
+    StatsScope stats(STATS_RIGHT_TANGENT, poly.size(), 2);
+    return rightTangentSearch(poly.size(), [&poly, point](int i)
+    {
+        return poly[i] - point;
+    },
+    [](const BasicPoint <T> &a, const BasicPoint <T> &b)
+    {
+        return a % b;
+    }, stats);
+}
+
+template <class T> int maximalPoint(const BasicPoint <T> &dir, const BasicPolygon <T> &poly)
+{
+    StatsScope stats(STATS_MAXIMAL_POINT, poly.size(), 1);
+    NullTracer tracer;
+    return maximalPointSearch(poly.size(), [&poly](int i)
+    {
+        return poly[i];
+    },
+    [dir](const BasicPoint <T> &a, const BasicPoint <T> &b)
+    {
+        return (a - b) * dir;
+    },
+    [](int, int, int) {}, [](int) {}, stats, tracer);
+}
+
+template <class T> int minimalPoint(const BasicPoint <T> &dir, const BasicPolygon <T> &poly)
+{
+    return maximalPoint(BasicPoint <T> ((T) -dir.x, (T) -dir.y), poly);
+}
+
+#define INSTANTIATE(T) \
+    template struct BasicPolygon <T>; \
+    template bool isInsideHalfPlanes(const BasicPoint <T>&, const BasicPolygon <T>&); \
+    template bool isInside(const BasicPoint <T>&, const BasicPolygon <T>&); \
+    template int leftTangent(const BasicPoint <T>&, const BasicPolygon <T>&); \
+    template int rightTangent(const BasicPoint <T>&, const BasicPolygon <T>&); \
+    template int maximalPoint(const BasicPoint <T>&, const BasicPolygon <T>&); \
+    template int minimalPoint(const BasicPoint <T>&, const BasicPolygon <T>&);
+
+INSTANTIATE(int16_t)
+#ifdef __SIZEOF_INT128__
+INSTANTIATE(int64_t)
+#endif
@@ -0,0 +1,109 @@
+#ifndef BASICGEOMETRY_H
+#define BASICGEOMETRY_H
+
+#include <cstdint>
+#include <vector>
+
+// Point and convex polygon with coordinates of type T, which is int16_t or int64_t
+// (the last one only if compiler supports 128-bit integers), for point queries only.
+// They are separate types, Point and Polygon from geometry.h are not instances of them,
+// and there are no lines, intersections, distances, hulls or bounds for them. Only the
+// binary searches are shared with Polygon through polygonsearch.h.
+// Coordinates should not exceed 2^(bits - 2) - 1 by an absolute value, then products
+// of differences of points fit in the twice wider type WideType <T>::type.
+// Queries are instantiated for every type, so there is no dispatch at runtime
+
+template <class T> struct WideType;
+template <> struct WideType <int16_t>
+{
+    typedef int32_t type;
+};
+#ifdef __SIZEOF_INT128__
+template <> struct WideType <int64_t>
+{
+    typedef __int128 type;
+};
+#endif
+
+template <class T> struct BasicPoint
+{
+    typedef typename WideType <T>::type Wide;
+    T x, y;
+
+    BasicPoint() : x(0), y(0) {}
+    BasicPoint(T _x, T _y) : x(_x), y(_y) {}
+
+    BasicPoint operator + (const BasicPoint &rhs) const
+    {
+        return BasicPoint((T) (x + rhs.x), (T) (y + rhs.y));
+    }
+    BasicPoint operator - (const BasicPoint &rhs) const
+    {
+        return BasicPoint((T) (x - rhs.x), (T) (y - rhs.y));
+    }
+    // Scalar multiplication of two vectors
+    Wide operator * (const BasicPoint &rhs) const
+    {
+        return (Wide) x * rhs.x + (Wide) y * rhs.y;
+    }
+    // Vector multiplication of two vectors
+    Wide operator % (const BasicPoint &rhs) const
+    {
+        return (Wide) x * rhs.y - (Wide) y * rhs.x;
+    }
+
+    bool operator == (const BasicPoint &rhs) const
+    {
+        return x == rhs.x && y == rhs.y;
+    }
+    bool operator != (const BasicPoint &rhs) const
+    {
+        return !(*this == rhs);
+    }
+};
+
+// Convex polygon stored in counter-clockwise order, see Polygon
+template <class T> struct BasicPolygon
+{
+    BasicPolygon(const std::vector <BasicPoint <T> > &points);
+    const BasicPoint <T>& operator [] (int i) const
+    {
+        if ((unsigned) i < points.size())
+            return points[i];
+        return points[(i % (int) points.size() + points.size()) % points.size()];
+    }
+    int size() const
+    {
+        return (int) points.size();
+    }
+    const BasicPoint <T>* data() const
+    {
+        return points.data();
+    }
+    int downmost, upmost;
+
+private:
+    std::vector <BasicPoint <T> > points;
+};
+
+// Same as the functions on Point and Polygon without tracing, angular index and bounds.
+// Binary searches are the ones from polygonsearch.h that Polygon uses too.
+// isInsideHalfPlanes is the linear check. Unlike isInsideLinear, which casts a ray, it
+// checks that point is not to the right of any side, in one loop without branches, so it
+// can be vectorized with more points in register for smaller coordinates. Points on the
+// border are inside for both
+template <class T> bool isInsideHalfPlanes(const BasicPoint <T> &point, const BasicPolygon <T> &poly);
+template <class T> bool isInside(const BasicPoint <T> &point, const BasicPolygon <T> &poly);
+template <class T> int leftTangent(const BasicPoint <T> &from, const BasicPolygon <T> &poly);
+template <class T> int rightTangent(const BasicPoint <T> &from, const BasicPolygon <T> &poly);
+template <class T> int maximalPoint(const BasicPoint <T> &dir, const BasicPolygon <T> &poly);
+template <class T> int minimalPoint(const BasicPoint <T> &dir, const BasicPolygon <T> &poly);
+
+typedef BasicPoint <int16_t> Point16;
+typedef BasicPolygon <int16_t> Polygon16;
+#ifdef __SIZEOF_INT128__
+typedef BasicPoint <int64_t> Point64;
+typedef BasicPolygon <int64_t> Polygon64;
+#endif
+
+#endif
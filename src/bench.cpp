@@ -0,0 +1,415 @@
+#include "geometry.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+using namespace std;
+
+// Benchmark of query functions. For every polygon size, polygon layout, cache state
+// and kind of queries it prints time, cycles and branch misses per query.
+// Usage: bench.exe [function filter] [maximal polygon size]
+
+const double timeBudget = 0.05;
+const int queryCount = 4096;
+// Cold runs go over copies of polygon that together take at least this much memory
+const size_t coldBytes = 64 << 20;
+
+// Hardware counters of cycles and branch misses. If perf events are not available
+// then cycles are counted with rdtsc and branch misses are not counted
+struct Counters
+{
+    Counters() : fd(-1)
+    {
+        #ifdef __linux__
+        fd = open(PERF_COUNT_HW_CPU_CYCLES, -1);
+        if (fd != -1 && open(PERF_COUNT_HW_BRANCH_MISSES, fd) == -1)
+        {
+            close(fd);
+            fd = -1;
+        }
+        #endif
+    }
+
+    ~Counters()
+    {
+        #ifdef __linux__
+        if (fd != -1)
+            close(fd);
+        #endif
+    }
+
+    bool hasBranchMisses() const
+    {
+        return fd != -1;
+    }
+
+    void start()
+    {
+        #ifdef __linux__
+        if (fd != -1)
+        {
+            ioctl(fd, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+            ioctl(fd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+            return;
+        }
+        #endif
+        tsc = readTsc();
+    }
+
+    void stop(unsigned long long &cycles, unsigned long long &branchMisses)
+    {
+        cycles = branchMisses = 0;
+        #ifdef __linux__
+        if (fd != -1)
+        {
+            ioctl(fd, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+            unsigned long long values[3] = {0, 0, 0};
+            if (read(fd, values, sizeof(values)) == (ssize_t) sizeof(values))
+            {
+                cycles = values[1];
+                branchMisses = values[2];
+            }
+            return;
+        }
+        #endif
+        cycles = readTsc() - tsc;
+    }
+
+private:
+    static unsigned long long readTsc()
+    {
+        #if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+        #else
+        return 0;
+        #endif
+    }
+
+    #ifdef __linux__
+    static int open(unsigned long long config, int group)
+    {
+        perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = config;
+        attr.disabled = group == -1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_GROUP;
+        return (int) syscall(__NR_perf_event_open, &attr, 0, -1, group, 0);
+    }
+    #endif
+
+    int fd;
+    unsigned long long tsc;
+};
+
+// Query is a point, a direction or a line through two points depending on function
+struct Query
+{
+    Point a, b;
+};
+
+enum Layout { PLAIN, INDEXED, SOA };
+enum QueryKind { ANY_POINT, OUTSIDE_POINT, DIRECTION, LINE };
+
+struct Variant
+{
+    const char *name;
+    Layout layout;
+    QueryKind kind;
+    // Number of queries passed to run at once
+    int block;
+    long long (*run)(const Polygon &poly, const Query *queries, int count);
+};
+
+long long runIsInsideLinear(const Polygon &poly, const Query *q, int) { return isInsideLinear(q->a, poly); }
+long long runIsInsideBS2(const Polygon &poly, const Query *q, int) { return isInsideBS2(q->a, poly); }
+long long runIsInside(const Polygon &poly, const Query *q, int) { return isInside(q->a, poly); }
+long long runIsInsideBatch(const Polygon &poly, const Query *q, int cnt)
+{
+    Point points[64];
+    bool result[64];
+    for (int i = 0; i < cnt; i++)
+        points[i] = q[i].a;
+    isInsideBatch(points, cnt, poly, result);
+    return count(result, result + cnt, true);
+}
+long long runIsInsideSorted(const Polygon &poly, const Query *q, int cnt)
+{
+    vector <Point> points(cnt);
+    vector <char> result(cnt);
+    for (int i = 0; i < cnt; i++)
+        points[i] = q[i].a;
+    isInsideSorted(points.data(), cnt, poly, (bool *) result.data());
+    return count(result.begin(), result.end(), 1);
+}
+long long runDistanceLinear(const Polygon &poly, const Query *q, int) { return (long long) distanceLinear(q->a, poly); }
+long long runDistance(const Polygon &poly, const Query *q, int) { return (long long) distance(q->a, poly); }
+long long runLeftTangentLinear(const Polygon &poly, const Query *q, int) { return leftTangentLinear(q->a, poly); }
+long long runLeftTangent(const Polygon &poly, const Query *q, int) { return leftTangent(q->a, poly); }
+long long runRightTangentLinear(const Polygon &poly, const Query *q, int) { return rightTangentLinear(q->a, poly); }
+long long runRightTangent(const Polygon &poly, const Query *q, int) { return rightTangent(q->a, poly); }
+long long runMaximalPointLinear(const Polygon &poly, const Query *q, int) { return maximalPointLinear(q->a, poly); }
+long long runMaximalPoint(const Polygon &poly, const Query *q, int) { return maximalPoint(q->a, poly); }
+long long runIntersectionLinear(const Polygon &poly, const Query *q, int)
+{
+    bool ok;
+    return (long long) intersectionLinear(Line(q->a, q->b), poly, &ok).first.x + ok;
+}
+long long runIntersection(const Polygon &poly, const Query *q, int)
+{
+    bool ok;
+    return (long long) intersection(Line(q->a, q->b), poly, &ok).first.x + ok;
+}
+
+const Variant variants[] = {
+    {"isInsideLinear", PLAIN, ANY_POINT, 1, runIsInsideLinear},
+    {"isInsideLinear", SOA, ANY_POINT, 1, runIsInsideLinear},
+    {"isInsideBS2", PLAIN, ANY_POINT, 1, runIsInsideBS2},
+    {"isInsideBS2", SOA, ANY_POINT, 1, runIsInsideBS2},
+    {"isInside", PLAIN, ANY_POINT, 1, runIsInside},
+    {"isInside", INDEXED, ANY_POINT, 1, runIsInside},
+    {"isInsideBatch", PLAIN, ANY_POINT, 64, runIsInsideBatch},
+    {"isInsideSorted", PLAIN, ANY_POINT, queryCount, runIsInsideSorted},
+    {"distanceLinear", PLAIN, OUTSIDE_POINT, 1, runDistanceLinear},
+    {"distanceLinear", SOA, OUTSIDE_POINT, 1, runDistanceLinear},
+    {"distance", PLAIN, OUTSIDE_POINT, 1, runDistance},
+    {"distance", INDEXED, OUTSIDE_POINT, 1, runDistance},
+    {"leftTangentLinear", PLAIN, OUTSIDE_POINT, 1, runLeftTangentLinear},
+    {"leftTangent", PLAIN, OUTSIDE_POINT, 1, runLeftTangent},
+    {"leftTangent", INDEXED, OUTSIDE_POINT, 1, runLeftTangent},
+    {"rightTangentLinear", PLAIN, OUTSIDE_POINT, 1, runRightTangentLinear},
+    {"rightTangent", PLAIN, OUTSIDE_POINT, 1, runRightTangent},
+    {"rightTangent", INDEXED, OUTSIDE_POINT, 1, runRightTangent},
+    {"maximalPointLinear", PLAIN, DIRECTION, 1, runMaximalPointLinear},
+    {"maximalPointLinear", SOA, DIRECTION, 1, runMaximalPointLinear},
+    {"maximalPoint", PLAIN, DIRECTION, 1, runMaximalPoint},
+    {"maximalPoint", INDEXED, DIRECTION, 1, runMaximalPoint},
+    {"intersectionLinear", PLAIN, LINE, 1, runIntersectionLinear},
+    {"intersectionLinear", SOA, LINE, 1, runIntersectionLinear},
+    {"intersection", PLAIN, LINE, 1, runIntersection},
+    {"intersection", INDEXED, LINE, 1, runIntersection},
+};
+
+const char *layoutNames[] = {"plain", "indexed", "soa"};
+
+unsigned long long randomState = 88172645463325252ull;
+
+// xorshift, so queries are the same on every platform
+int randomInt(int from, int to)
+{
+    randomState ^= randomState << 13;
+    randomState ^= randomState >> 7;
+    randomState ^= randomState << 17;
+    return from + (int) (randomState % (unsigned long long) (to - from + 1));
+}
+
+Point randomPoint(const Point &from, const Point &to)
+{
+    return Point(randomInt(from.x, to.x), randomInt(from.y, to.y));
+}
+
+// Random queries are uniform in the bounding box that is expanded in both directions.
+// Adversarial ones hit degenerate cases: vertices, points on continuations of sides
+// (collinear with a side), normals of sides (two maximal points) and lines through sides
+vector <Query> genQueries(const Polygon &poly, QueryKind kind, bool adversarial)
+{
+    Point low = poly[0], high = poly[0];
+    for (int i = 0; i < poly.size(); i++)
+    {
+        low = Point(min(low.x, poly[i].x), min(low.y, poly[i].y));
+        high = Point(max(high.x, poly[i].x), max(high.y, poly[i].y));
+    }
+    Point margin = high - low;
+    low -= margin;
+    high += margin;
+    vector <Query> queries;
+    while ((int) queries.size() < queryCount)
+    {
+        int i = randomInt(0, poly.size() - 1);
+        Point side = poly[i + 1] - poly[i];
+        Query q;
+        q.a = randomPoint(low, high);
+        q.b = randomPoint(low, high);
+        switch (kind)
+        {
+        case ANY_POINT:
+            if (adversarial)
+                q.a = randomInt(0, 1) ? poly[i] : poly[i + 1] + side;
+            break;
+        case OUTSIDE_POINT:
+            if (adversarial)
+                q.a = poly[i + 1] + side;
+            else if (isInside(q.a, poly))
+                continue;
+            break;
+        case DIRECTION:
+            q.a = adversarial ? Point(side.y, -side.x) : randomPoint(Point(-(1<<20), -(1<<20)), Point(1<<20, 1<<20));
+            if (q.a == Point(0, 0))
+                continue;
+            break;
+        case LINE:
+            if (adversarial)
+            {
+                q.a = poly[i];
+                q.b = randomInt(0, 1) ? poly[i + 1] : poly[randomInt(0, poly.size() - 1)];
+            }
+            if (q.a == q.b)
+                continue;
+            break;
+        }
+        queries.push_back(q);
+    }
+    return queries;
+}
+
+struct Result
+{
+    long long queries;
+    double ns, cycles, branchMisses;
+};
+
+volatile long long sink;
+
+Result measure(const Variant &variant, const vector <Polygon> &pool, const vector <Query> &queries, Counters &counters)
+{
+    long long done = 0, acc = 0;
+    unsigned long long totalCycles = 0, totalMisses = 0;
+    size_t copy = 0, next = 0;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    double elapsed = 0;
+    while (elapsed < timeBudget || done < 16)
+    {
+        unsigned long long cycles, misses;
+        counters.start();
+        for (int i = 0; i < 16; i++)
+        {
+            acc += variant.run(pool[copy], &queries[next], variant.block);
+            done += variant.block;
+            next += variant.block;
+            if (next + variant.block > queries.size())
+                next = 0;
+            if (++copy == pool.size())
+                copy = 0;
+        }
+        counters.stop(cycles, misses);
+        totalCycles += cycles;
+        totalMisses += misses;
+        elapsed = chrono::duration <double> (chrono::steady_clock::now() - start).count();
+    }
+    sink = acc;
+    Result result;
+    result.queries = done;
+    result.ns = elapsed * 1e9 / (double) done;
+    result.cycles = (double) totalCycles / (double) done;
+    result.branchMisses = (double) totalMisses / (double) done;
+    return result;
+}
+
+vector <Polygon> buildPool(const Polygon &poly, Layout layout, size_t copies)
+{
+    Polygon prepared = poly;
+    if (layout == INDEXED)
+        prepared.buildAngularIndex();
+    if (layout == SOA)
+        prepared.buildSoA();
+    return vector <Polygon> (copies, prepared);
+}
+
+int main(int argc, char **argv)
+{
+    string filter = argc > 1 ? argv[1] : "";
+    int maxSize = argc > 2 ? atoi(argv[2]) : 1000000;
+    const int sizes[] = {3, 10, 30, 100, 300, 1000, 3000, 10000, 30000, 100000, 300000, 1000000};
+    const int variantCount = (int) (sizeof(variants) / sizeof(variants[0]));
+    Counters counters;
+    if (!counters.hasBranchMisses())
+        printf("# perf events are not available: cycles are counted with rdtsc, branch misses are not counted\n");
+    printf("%-20s %-8s %8s %-5s %-11s %10s %12s %12s %12s\n",
+           "function", "layout", "n", "cache", "queries", "count", "ns/query", "cycles/query", "misses/query");
+    // Time of warm random queries, to find where binary search starts to beat linear scan
+    vector <vector <double> > warmTime(variantCount);
+    vector <int> measuredSizes;
+    for (int size : sizes)
+    {
+        if (size > maxSize)
+            break;
+        measuredSizes.push_back(size);
+        // Queries go up to the bounding box expanded in both directions, so they stay within 2^30
+        Polygon poly = genLargePolygon(size, 1 << 28, 2016);
+        vector <Query> queries[4][2];
+        for (int kind = 0; kind < 4; kind++)
+            for (int adversarial = 0; adversarial < 2; adversarial++)
+                queries[kind][adversarial] = genQueries(poly, (QueryKind) kind, adversarial);
+        size_t coldCopies = max((size_t) 2, min((size_t) 1 << 18, coldBytes / (sizeof(Point) * (size_t) size)));
+        for (int layout = PLAIN; layout <= SOA; layout++)
+        {
+            vector <Polygon> pool;
+            for (int cold = 0; cold < 2; cold++)
+            {
+                bool needed = 0;
+                for (int v = 0; v < variantCount; v++)
+                    needed |= variants[v].layout == layout && string(variants[v].name).find(filter) != string::npos;
+                if (!needed)
+                    continue;
+                pool = buildPool(poly, (Layout) layout, cold ? coldCopies : 1);
+                for (int v = 0; v < variantCount; v++)
+                {
+                    const Variant &variant = variants[v];
+                    if (variant.layout != layout || string(variant.name).find(filter) == string::npos)
+                        continue;
+                    for (int adversarial = 0; adversarial < 2; adversarial++)
+                    {
+                        Result r = measure(variant, pool, queries[variant.kind][adversarial], counters);
+                        if (!cold && !adversarial)
+                            warmTime[v].push_back(r.ns);
+                        printf("%-20s %-8s %8d %-5s %-11s %10lld %12.1f %12.1f", variant.name, layoutNames[layout],
+                               size, cold ? "cold" : "warm", adversarial ? "adversarial" : "random", r.queries, r.ns, r.cycles);
+                        if (counters.hasBranchMisses())
+                            printf(" %12.2f\n", r.branchMisses);
+                        else
+                            printf(" %12s\n", "-");
+                        fflush(stdout);
+                    }
+                }
+            }
+        }
+    }
+    printf("\n# Smallest size at which a function beats the linear one of the same family (warm, random)\n");
+    for (int v = 0; v < variantCount; v++)
+    {
+        string name = variants[v].name;
+        if (name.find("Linear") != string::npos || warmTime[v].empty())
+            continue;
+        for (int w = 0; w < variantCount; w++)
+        {
+            string linear = variants[w].name;
+            if (linear.find("Linear") == string::npos || warmTime[w].size() != warmTime[v].size() ||
+                name.compare(0, linear.size() - 6, linear, 0, linear.size() - 6) != 0)
+                continue;
+            size_t i = 0;
+            while (i < warmTime[v].size() && warmTime[v][i] >= warmTime[w][i])
+                i++;
+            printf("%-20s %-8s vs %-20s %-8s: ", name.c_str(), layoutNames[variants[v].layout], linear.c_str(), layoutNames[variants[w].layout]);
+            if (i < warmTime[v].size())
+                printf("n >= %d\n", measuredSizes[i]);
+            else
+                printf("never\n");
+        }
+    }
+}
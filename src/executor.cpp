@@ -0,0 +1,192 @@
+#include "executor.h"
+#include <algorithm>
+
+using namespace std;
+
+Executor::Executor(int threadsCount) : job(NULL), remaining(0), generation(0), stopping(0)
+{
+    if (threadsCount <= 0)
+        threadsCount = max(1, (int) thread::hardware_concurrency());
+    for (int i = 0; i < threadsCount; i++)
+        queues.push_back(unique_ptr <Queue> (new Queue()));
+    for (int i = 1; i < threadsCount; i++)
+        threads.push_back(thread(&Executor::work, this, i));
+}
+
+Executor::~Executor()
+{
+    {
+        lock_guard <std::mutex> lock(mutex);
+        stopping = 1;
+    }
+    wake.notify_all();
+    for (auto &t : threads)
+        t.join();
+}
+
+int Executor::threadCount() const
+{
+    return (int) queues.size();
+}
+
+int Executor::chunkSize(int count, size_t bytesPerQuery) const
+{
+    const size_t cacheBytes = 16 << 10;
+    int byCache = max(1, (int) (cacheBytes / bytesPerQuery));
+    int byBalance = max(1, count / (threadCount() * 8));
+    return min(byCache, byBalance);
+}
+
+void Executor::run(int count, int chunk, const function <void(int, int)> &f)
+{
+    if (count <= 0)
+        return;
+    if (threadCount() == 1)
+    {
+        f(0, count);
+        return;
+    }
+    int chunks = (count + chunk - 1) / chunk;
+    job = &f;
+    remaining = chunks;
+    // Consecutive chunks go to the same thread, so stolen chunks are far from the owner's ones
+    for (int t = 0; t < threadCount(); t++)
+    {
+        lock_guard <std::mutex> lock(queues[t]->mutex);
+        for (int c = (int) ((long long) chunks * t / threadCount()); c < (int) ((long long) chunks * (t + 1) / threadCount()); c++)
+            queues[t]->chunks.push_back(make_pair(c * chunk, min(count, (c + 1) * chunk)));
+    }
+    {
+        lock_guard <std::mutex> lock(mutex);
+        generation++;
+    }
+    wake.notify_all();
+    while (runChunk(0))
+        ;
+    unique_lock <std::mutex> lock(mutex);
+    done.wait(lock, [this] { return remaining == 0; });
+}
+
+bool Executor::runChunk(int id)
+{
+    pair <int, int> range;
+    bool found = 0;
+    for (int i = 0; i < threadCount() && !found; i++)
+    {
+        Queue &queue = *queues[(id + i) % threadCount()];
+        lock_guard <std::mutex> lock(queue.mutex);
+        if (queue.chunks.empty())
+            continue;
+        // Owner takes chunks from the front and thieves from the back
+        if (i == 0)
+        {
+            range = queue.chunks.front();
+            queue.chunks.pop_front();
+        }
+        else
+        {
+            range = queue.chunks.back();
+            queue.chunks.pop_back();
+        }
+        found = 1;
+    }
+    if (!found)
+        return 0;
+    (*job)(range.first, range.second);
+    if (--remaining == 0)
+    {
+        lock_guard <std::mutex> lock(mutex);
+        done.notify_all();
+    }
+    return 1;
+}
+
+void Executor::work(int id)
+{
+    int seen = 0;
+    while (1)
+    {
+        {
+            unique_lock <std::mutex> lock(mutex);
+            wake.wait(lock, [&] { return stopping || generation != seen; });
+            if (stopping)
+                return;
+            seen = generation;
+        }
+        while (runChunk(id))
+            ;
+    }
+}
+
+void Executor::isInside(const Polygon &poly, const Point *points, int count, bool *result)
+{
+    run(count, chunkSize(count, sizeof(Point) + sizeof(bool)), [&](int from, int to)
+    {
+        isInsideBatch(points + from, to - from, poly, result + from);
+    });
+}
+
+void Executor::distance(const Polygon &poly, const Point *points, int count, double *result)
+{
+    run(count, chunkSize(count, sizeof(Point) + sizeof(double)), [&](int from, int to)
+    {
+        for (int i = from; i < to; i++)
+            result[i] = ::distance(points[i], poly);
+    });
+}
+
+void Executor::leftTangent(const Polygon &poly, const Point *points, int count, int *result)
+{
+    run(count, chunkSize(count, sizeof(Point) + sizeof(int)), [&](int from, int to)
+    {
+        for (int i = from; i < to; i++)
+            result[i] = ::leftTangent(points[i], poly);
+    });
+}
+
+void Executor::rightTangent(const Polygon &poly, const Point *points, int count, int *result)
+{
+    run(count, chunkSize(count, sizeof(Point) + sizeof(int)), [&](int from, int to)
+    {
+        for (int i = from; i < to; i++)
+            result[i] = ::rightTangent(points[i], poly);
+    });
+}
+
+void Executor::maximalPoint(const Polygon &poly, const Point *dirs, int count, int *result)
+{
+    run(count, chunkSize(count, sizeof(Point) + sizeof(int)), [&](int from, int to)
+    {
+        for (int i = from; i < to; i++)
+            result[i] = ::maximalPoint(dirs[i], poly);
+    });
+}
+
+void Executor::intersection(const Polygon &poly, const Line *lines, int count, SegmentDouble *result, bool *ok)
+{
+    run(count, chunkSize(count, sizeof(Line) + sizeof(SegmentDouble) + sizeof(bool)), [&](int from, int to)
+    {
+        for (int i = from; i < to; i++)
+            result[i] = ::intersection(lines[i], poly, ok ? ok + i : NULL);
+    });
+}
+
+Polygon Executor::convexHull(const Point *points, int count, bool *ok)
+{
+    int chunk = chunkSize(count, sizeof(Point));
+    vector <vector <Point> > hulls((count + chunk - 1) / chunk);
+    run(count, chunk, [&](int from, int to)
+    {
+        // With one thread the whole range comes at once, it is still split to sort in cache
+        for (; from < to; from += chunk)
+        {
+            vector <Point> &hull = hulls[from / chunk];
+            hull.assign(points + from, points + min(to, from + chunk));
+            hullVertices(hull);
+        }
+    });
+    vector <Point> vertices;
+    for (auto &hull : hulls)
+        vertices.insert(vertices.end(), hull.begin(), hull.end());
+    return ::convexHull(vertices, ok);
+}
@@ -0,0 +1,69 @@
+#ifndef EXECUTOR_H
+#define EXECUTOR_H
+
+#include "geometry.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Pool of threads that answers batches of queries against one read-only polygon.
+// Batch is split into chunks that fit in cache. Every thread takes chunks from
+// its own queue and steals them from other queues when it is empty. Result i
+// always corresponds to query i, so output does not depend on number of threads.
+// Batches should be run from one thread at a time.
+struct Executor
+{
+    // If threads == 0 then one thread per processor is used.
+    // The calling thread is one of them, so Executor(1) starts no threads
+    explicit Executor(int threads = 0);
+    ~Executor();
+    Executor(const Executor&) = delete;
+    Executor& operator = (const Executor&) = delete;
+
+    int threadCount() const;
+
+    void isInside(const Polygon &poly, const Point *points, int count, bool *result);
+    void distance(const Polygon &poly, const Point *points, int count, double *result);
+    void leftTangent(const Polygon &poly, const Point *points, int count, int *result);
+    void rightTangent(const Polygon &poly, const Point *points, int count, int *result);
+    void maximalPoint(const Polygon &poly, const Point *dirs, int count, int *result);
+    // ok may be NULL
+    void intersection(const Polygon &poly, const Line *lines, int count, SegmentDouble *result, bool *ok = NULL);
+    // Same as ::convexHull of points[0..count-1]. Every chunk is sorted and reduced
+    // to its hull in parallel, then the hull of their vertices is built
+    Polygon convexHull(const Point *points, int count, bool *ok = NULL);
+
+    // Calls job(from, to) for disjoint ranges that cover [0, count) and waits for them.
+    // Ranges have at most chunk elements
+    void run(int count, int chunk, const std::function <void(int, int)> &job);
+
+private:
+    struct Queue
+    {
+        std::mutex mutex;
+        std::deque <std::pair <int, int> > chunks;
+    };
+
+    // Number of queries in chunk, so that queries and results of it fit in L1 cache
+    // and every thread gets several chunks to balance the load
+    int chunkSize(int count, size_t bytesPerQuery) const;
+    bool runChunk(int id);
+    void work(int id);
+
+    std::vector <std::unique_ptr <Queue> > queues;
+    std::vector <std::thread> threads;
+    std::mutex mutex;
+    std::condition_variable wake, done;
+    const std::function <void(int, int)> *job;
+    std::atomic <int> remaining;
+    int generation;
+    bool stopping;
+};
+
+#endif
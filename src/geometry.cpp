@@ -1,18 +1,18 @@
 #include "geometry.h"
+#include "polygonsearch.h"
 #include <cmath>
 #include <cstring>
 #include <iostream>
 #include <algorithm>
+#include <random>
 
-using namespace std;
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define GEOMETRY_AVX2
+#endif
 
+using namespace std;
 
-int sign(long long a)
-{
-    if (!a)
-        return 0;
-    return a > 0 ? 1 : -1;
-}
 
 inline void setOk(bool *ok, int res)
 {
@@ -21,147 +21,303 @@ inline void setOk(bool *ok, int res)
 }
 
 
-Point::Point() : x(0), y(0) {}
-Point::Point(int _x, int _y) : x(_x), y(_y) {}
-
-Point Point::operator + (const Point &a) const
+Point::operator PointDouble() const
 {
-    return Point(x + a.x, y + a.y);
+    return PointDouble(x, y);
 }
 
-Point Point::operator - (const Point &a) const
+double Point::len() const
 {
-    return Point(x - a.x, y - a.y);
+    return sqrt(sqr(1ll * x) + sqr(1ll * y));
 }
 
-long long Point::operator * (const Point &a) const
-{
-    return 1ll * x * a.x + 1ll * y * a.y;
-}
+PointDouble::PointDouble() : x(0), y(0) {}
+PointDouble::PointDouble(double _x, double _y) : x(_x), y(_y) {}
 
-long long Point::operator % (const Point &a) const
+bool PointDouble::operator == (const PointDouble &a) const
 {
-    return 1ll * x * a.y - 1ll * y * a.x;
+    return abs(x - a.x) < eps && abs(y - a.y) < eps;
 }
 
-Point Point::operator * (int a) const
+bool PointDouble::operator != (const PointDouble &a) const
 {
-    return Point(x * a, y * a);
+    return abs(x - a.x) >= eps || abs(y - a.y) >= eps;
 }
 
-Point& Point::operator += (const Point &a)
+Segment::Segment(){}
+
+Segment::Segment(const Point &a, const Point &b): first(a), second(b){}
+
+bool Segment::operator == (const Segment &other) const
 {
-    x += a.x;
-    y += a.y;
-    return *this;
+    return (first == other.first && second == other.second) ||
+           (first == other.second && second == other.first);
 }
 
-Point& Point::operator -= (const Point &a)
+SegmentDouble::SegmentDouble(){}
+
+SegmentDouble::SegmentDouble(const PointDouble &a, const PointDouble &b): first(a), second(b){}
+
+bool SegmentDouble::operator == (const SegmentDouble &other) const
 {
-    x -= a.x;
-    y -= a.y;
-    return *this;
+    return (first == other.first && second == other.second) ||
+           (first == other.second && second == other.first);
 }
 
-bool Point::operator == (const Point &a) const
+Ray::Ray(const Point &a, const Point &b): start(a), dir(b){}
+
+// Finds topmost and lowest vertices, the rightmost ones among equal
+static void findExtremes(const Point *points, int count, int &upmost, int &downmost)
 {
-    return x == a.x && y == a.y;
+    upmost = downmost = 0;
+    for (int i = 0; i < count; i++)
+    {
+        if (points[i].y > points[upmost].y || (points[i].y == points[upmost].y && points[i].x > points[upmost].x))
+            upmost = i;
+        if (points[i].y < points[downmost].y || (points[i].y == points[downmost].y && points[i].x > points[downmost].x))
+            downmost = i;
+    }
 }
 
-bool Point::operator != (const Point &a) const
+// First vertex i of the chain from, from + 1, ..., to such that side from it does not go
+// in direction dir, or to if there is no such vertex. Sides of the chain should turn
+// by less than 180 degrees, then projections to dir grow till this vertex and decrease after it
+inline int extremeOnChain(const Point *points, int n, int from, int to, const Point &dir)
 {
-    return x != a.x || y != a.y;
+    int l = from - 1, r = to < from ? to + n : to;
+    while (r - l > 1)
+    {
+        int m = (l + r) / 2;
+        if ((points[(m + 1) % n] - points[m % n]) * dir <= 0)
+            r = m;
+        else
+            l = m;
+    }
+    return r % n;
 }
 
-Point::operator PointDouble() const
+// Extreme vertices in directions (1, 0), (-1, 0) and diagonal ones lie on chains
+// between upmost and downmost ones and then between neighbouring extreme vertices
+static Bounds findBounds(const Point *points, int n, int upmost, int downmost)
 {
-    return PointDouble(x, y);
+    Bounds b;
+    int *e = b.extremes;
+    if (n == 0)
+    {
+        fill(e, e + 8, 0);
+        b.minX = b.minY = 1;
+        b.maxX = b.maxY = 0;
+        b.minSum = b.minDiff = 1;
+        b.maxSum = b.maxDiff = 0;
+        return b;
+    }
+    e[2] = upmost;
+    e[6] = downmost;
+    e[0] = extremeOnChain(points, n, e[6], e[2], Point(1, 0));
+    e[4] = extremeOnChain(points, n, e[2], e[6], Point(-1, 0));
+    e[1] = extremeOnChain(points, n, e[0], e[2], Point(1, 1));
+    e[3] = extremeOnChain(points, n, e[2], e[4], Point(-1, 1));
+    e[5] = extremeOnChain(points, n, e[4], e[6], Point(-1, -1));
+    e[7] = extremeOnChain(points, n, e[6], e[0], Point(1, -1));
+    b.maxX = points[e[0]].x;
+    b.maxY = points[e[2]].y;
+    b.minX = points[e[4]].x;
+    b.minY = points[e[6]].y;
+    b.maxSum = points[e[1]].x + 1ll * points[e[1]].y;
+    b.minSum = points[e[5]].x + 1ll * points[e[5]].y;
+    b.minDiff = points[e[3]].x - 1ll * points[e[3]].y;
+    b.maxDiff = points[e[7]].x - 1ll * points[e[7]].y;
+    return b;
 }
 
-double Point::len() const
+PolygonView::PolygonView(const Point *p, int n, bool *ok) : points(p), count(n)
 {
-    return sqrt(sqr(1ll * x) + sqr(1ll * y));
+    setOk(ok, n < 3 || (p[2] - p[0]) % (p[1] - p[0]) <= 0);
+    findExtremes(p, n, upmost, downmost);
+    bounds = findBounds(p, n, upmost, downmost);
 }
 
-long long Point::len2() const
+PolygonView::PolygonView(const Point *p, int n, int _upmost, int _downmost) :
+    points(p), count(n), downmost(_downmost), upmost(_upmost), bounds(findBounds(p, n, _upmost, _downmost)) {}
+
+PolygonView::PolygonView(const Point *p, int n, int _upmost, int _downmost, const Bounds &_bounds) :
+    points(p), count(n), downmost(_downmost), upmost(_upmost), bounds(_bounds) {}
+
+Polygon::Polygon(const vector <Point> &p) : Polygon(vector <Point>(p)) {}
+
+Polygon::Polygon(vector <Point> &&p) : radius(0), points(std::move(p))
 {
-    return sqr(1ll * x) + sqr(1ll * y);
+    if (points.size() >= 3 && (points[2] - points[0]) % (points[1] - points[0]) > 0)
+        reverse(points.begin(), points.end());
+    vertices = points.data();
+    count = (int) points.size();
+    findExtremes(vertices, count, upmost, downmost);
+    bounds = findBounds(vertices, count, upmost, downmost);
 }
 
-PointDouble::PointDouble() : x(0), y(0) {}
-PointDouble::PointDouble(double _x, double _y) : x(_x), y(_y) {}
+Polygon::Polygon(const PolygonView &view) :
+    downmost(view.downmost), upmost(view.upmost), bounds(view.bounds), radius(0), vertices(view.points), count(view.count) {}
 
-bool PointDouble::operator == (const PointDouble &a) const
+Polygon::Polygon(const Polygon &other)
 {
-    return abs(x - a.x) < eps && abs(y - a.y) < eps;
+    *this = other;
 }
 
-bool PointDouble::operator != (const PointDouble &a) const
+Polygon::Polygon(Polygon &&other)
 {
-    return abs(x - a.x) >= eps || abs(y - a.y) >= eps;
+    *this = std::move(other);
 }
 
-Segment::Segment(){}
+Polygon& Polygon::operator = (const Polygon &other)
+{
+    if (this == &other)
+        return *this;
+    downmost = other.downmost;
+    upmost = other.upmost;
+    bounds = other.bounds;
+    fanIndex = other.fanIndex;
+    sideIndex = other.sideIndex;
+    center = other.center;
+    radius = other.radius;
+    points = other.points;
+    x = other.x;
+    y = other.y;
+    // Copy of owned vertices is owned too
+    vertices = points.empty() ? other.vertices : points.data();
+    count = other.count;
+    return *this;
+}
 
-Segment::Segment(const Point &a, const Point &b): first(a), second(b){}
+Polygon& Polygon::operator = (Polygon &&other)
+{
+    // Moving into itself would release the vertices
+    if (this == &other)
+        return *this;
+    downmost = other.downmost;
+    upmost = other.upmost;
+    bounds = other.bounds;
+    fanIndex = std::move(other.fanIndex);
+    sideIndex = std::move(other.sideIndex);
+    center = other.center;
+    radius = other.radius;
+    // Moved vector keeps its buffer, so owned vertices stay where they were
+    points = std::move(other.points);
+    x = std::move(other.x);
+    y = std::move(other.y);
+    vertices = other.vertices;
+    count = other.count;
+    other.vertices = NULL;
+    other.count = 0;
+    return *this;
+}
 
-bool Segment::operator == (const Segment &other) const
+PolygonView Polygon::view() const
 {
-    return (first == other.first && second == other.second) ||
-           (first == other.second && second == other.first);
+    return PolygonView(vertices, count, upmost, downmost, bounds);
 }
 
-SegmentDouble::SegmentDouble(){}
-
-SegmentDouble::SegmentDouble(const PointDouble &a, const PointDouble &b): first(a), second(b){}
+const Point& Polygon::operator [] (int i) const
+{
+    if ((unsigned) i < (unsigned) count)
+        return vertices[i];
+    return vertices[(i % count + count) % count];
+}
 
-bool SegmentDouble::operator == (const SegmentDouble &other) const
+int Polygon::size() const
 {
-    return (first == other.first && second == other.second) ||
-           (first == other.second && second == other.first);
+    return count;
 }
 
-Ray::Ray(const Point &a, const Point &b): start(a), dir(b){}
+const Point* Polygon::data() const
+{
+    return vertices;
+}
 
-Line::Line(const Point &first, const Point &second)
+inline double relativeAngle(double angle, double origin)
 {
-    a = second.y - first.y;
-    b = first.x - second.x;
-    c = 1ll * first.y * second.x - 1ll * first.x * second.y;
+    return angle < origin ? angle - origin + 4 : angle - origin;
 }
 
-Point Line::normal() const
+void Polygon::buildAngularIndex(int buckets)
 {
-    return Point(a, b);
+    if (buckets <= 0)
+        buckets = size();
+    double origin = pseudoAngle(vertices[1] - vertices[0]);
+    vector <double> angles;
+    for (int i = 1; i < size(); i++)
+        angles.push_back(relativeAngle(pseudoAngle(vertices[i] - vertices[0]), origin));
+    fanIndex = AngularIndex(angles, origin, 2, buckets);
+    angles.clear();
+    for (int i = 0; i < size(); i++)
+        angles.push_back(relativeAngle(pseudoAngle((*this)[i + 1] - vertices[i]), origin));
+    sideIndex = AngularIndex(angles, origin, 4, buckets);
+    double x = 0, y = 0;
+    for (int i = 0; i < size(); i++)
+    {
+        x += vertices[i].x;
+        y += vertices[i].y;
+    }
+    center = PointDouble(x / size(), y / size());
+    radius = 0;
+    for (int i = 0; i < size(); i++)
+        radius += sqrt(sqr(vertices[i].x - center.x) + sqr(vertices[i].y - center.y)) / size();
 }
 
-Point Line::direction() const
+bool Polygon::hasAngularIndex() const
 {
-    return Point(-b, a);
+    return !fanIndex.first.empty();
 }
 
-Polygon::Polygon(const vector <Point> &p) : points(p) 
+void Polygon::buildSoA()
 {
-    if ((points[2] - points[0]) % (points[1] - points[0]) > 0)
-        reverse(points.begin(), points.end());
-    upmost = downmost = 0;
-    for (int i = 0; i < (int) points.size(); i++)
+    x.resize(size() + soaPadding);
+    y.resize(size() + soaPadding);
+    for (int i = 0; i < size() + soaPadding; i++)
     {
-        if (points[i].y > points[upmost].y || (points[i].y == points[upmost].y && points[i].x > points[upmost].x))
-            upmost = i;
-        if (points[i].y < points[downmost].y || (points[i].y == points[downmost].y && points[i].x > points[downmost].x))
-            downmost = i;
+        x[i] = (*this)[i].x;
+        y[i] = (*this)[i].y;
     }
 }
 
-const Point& Polygon::operator [] (int i) const
+bool Polygon::hasSoA() const
 {
-    return points[(i % (int) points.size() + points.size()) % points.size()];
+    return !x.empty();
 }
 
-int Polygon::size() const
+const int* Polygon::xs() const
+{
+    return x.data();
+}
+
+const int* Polygon::ys() const
+{
+    return y.data();
+}
+
+AngularIndex::AngularIndex() : origin(0), span(0) {}
+
+AngularIndex::AngularIndex(const vector <double> &angles, double _origin, double _span, int buckets) :
+    first(buckets + 1, (int) angles.size()), origin(_origin), span(_span)
+{
+    int j = 0;
+    for (int b = 0; b < buckets; b++)
+    {
+        while (j < (int) angles.size() && angles[j] < span * b / buckets)
+            j++;
+        first[b] = j;
+    }
+}
+
+void AngularIndex::range(double angle, int &from, int &to) const
 {
-    return (int) points.size();
+    angle = relativeAngle(angle, origin);
+    if (angle >= span)
+        angle = angle - span < 4 - angle ? span : 0;
+    int buckets = (int) first.size() - 1;
+    int b = min(max((int) (angle / span * buckets), 0), buckets - 1);
+    // Neighbouring buckets are taken too, so rounding errors do not matter
+    from = first[max(b - 1, 0)];
+    to = first[min(b + 2, buckets)];
 }
 
 ostream& operator << (ostream &out, const Point &p)
@@ -213,69 +369,137 @@ ostream& operator << (ostream &out, const SegmentDouble &segment)
     return out;
 }
 
-void drawPoint(FILE *out, const Point& point, const char *name)
+TraceWriter::TraceWriter(FILE *_out) : out(_out), size(0) {}
+
+TraceWriter::~TraceWriter()
+{
+    flush();
+}
+
+void TraceWriter::flush()
+{
+    fwrite(buffer, 1, size, out);
+    size = 0;
+}
+
+TraceWriter& TraceWriter::operator << (const char *s)
+{
+    for (; *s; s++)
+        *this << *s;
+    return *this;
+}
+
+TraceWriter& TraceWriter::operator << (char c)
+{
+    if (size == capacity)
+        flush();
+    buffer[size++] = c;
+    return *this;
+}
+
+TraceWriter& TraceWriter::operator << (int a)
+{
+    return *this << (long long) a;
+}
+
+TraceWriter& TraceWriter::operator << (long long a)
+{
+    char digits[24];
+    int cnt = 0;
+    unsigned long long value = a < 0 ? 0ull - (unsigned long long) a : (unsigned long long) a;
+    do
+    {
+        digits[cnt++] = char('0' + value % 10);
+        value /= 10;
+    } while (value);
+    if (a < 0)
+        *this << '-';
+    while (cnt)
+        *this << digits[--cnt];
+    return *this;
+}
+
+TraceWriter& TraceWriter::operator << (double a)
+{
+    char s[64];
+    snprintf(s, sizeof(s), "%f", a);
+    return *this << (const char*) s;
+}
+
+inline void drawName(TraceWriter &out, const char *name)
+{
+    if (*name)
+        out << " name=" << name;
+    out << '\n';
+}
+
+void drawPoint(TraceWriter &out, const Point& point, const char *name)
 {
-    fprintf(out, "point %d %d", point.x, point.y);
-    if (strlen(name))
-        fprintf(out, " name=%s", name); 
-    fprintf(out, "\n");
+    out << "point " << point.x << ' ' << point.y;
+    drawName(out, name);
 }   
 
-void drawPoint(FILE *out, const PointDouble& point, const char *name)
+void drawPoint(TraceWriter &out, const PointDouble& point, const char *name)
 {
-    fprintf(out, "point %f %f", point.x, point.y);
-    if (strlen(name))
-        fprintf(out, " name=%s", name); 
-    fprintf(out, "\n");
+    out << "point " << point.x << ' ' << point.y;
+    drawName(out, name);
 }   
 
-void drawSegment(FILE *out, const Point &from, const Point &to, const char* color, const char *name)
+void drawSegment(TraceWriter &out, const Point &from, const Point &to, const char* color, const char *name)
+{
+    out << "segment " << from.x << ' ' << from.y << ' ' << to.x << ' ' << to.y << " color=" << color;
+    drawName(out, name);
+}
+
+void drawVector(TraceWriter &out, const Point &from, const Point &to, const char* color, const char *name)
 {
-    fprintf(out, "segment %d %d %d %d color=%s", from.x, from.y, to.x, to.y, color); 
-    if (strlen(name))
-        fprintf(out, " name=%s", name); 
-    fprintf(out, "\n");
+    out << "vector " << from.x << ' ' << from.y << ' ' << to.x << ' ' << to.y << " color=" << color;
+    drawName(out, name);
 }
 
-void drawVector(FILE *out, const Point &from, const Point &to, const char* color, const char *name)
+void drawRay(TraceWriter &out, const Point &from, const Point &dir, const char* color, const char *name)
 {
-    fprintf(out, "vector %d %d %d %d color=%s", from.x, from.y, to.x, to.y, color); 
-    if (strlen(name))
-        fprintf(out, " name=%s", name); 
-    fprintf(out, "\n");
+    out << "ray " << from.x << ' ' << from.y << ' ' << dir.x << ' ' << dir.y << " color=" << color;
+    drawName(out, name);
 }
 
-void drawRay(FILE *out, const Point &from, const Point &dir, const char* color, const char *name)
+void drawLine(TraceWriter &out, const Line &line, const char* color)
 {
-    fprintf(out, "ray %d %d %d %d color=%s", from.x, from.y, dir.x, dir.y, color);
-    if (strlen(name))
-        fprintf(out, "name=%s", name); 
-    fprintf(out, "\n");
+    out << "line " << line.a << ' ' << line.b << ' ' << line.c << " color=" << color << '\n';
 }
 
-void drawLine(FILE *out, const Line &line, const char* color)
+void drawAngle(TraceWriter &out, const Point &vertex, const Point &first, const Point &second, bool withArc)
 {
-    fprintf(out, "line %d %d %I64d color=%s\n", line.a, line.b, line.c, color);
+    out << "angle " << vertex.x << ' ' << vertex.y << ' ' << first.x << ' ' << first.y << ' ' 
+        << second.x << ' ' << second.y << " arc=" << (int) withArc << '\n';
 }
 
-void drawAngle(FILE *out, const Point &vertex, const Point &first, const Point &second, bool withArc)
+void drawPolygon(TraceWriter &out, const Polygon &poly)
 {
-    fprintf(out, "angle %d %d %d %d %d %d arc=%d\n", vertex.x, vertex.y, first.x, first.y, second.x, second.y, withArc);        
+    out << "polygon " << poly.size();
+    for (int i = 0; i < poly.size(); i++)
+        out << ' ' << poly[i].x << ' ' << poly[i].y;
+    out << '\n';
+}
+
+void drawState(TraceWriter &out, int l, int m, int r)
+{
+    out << "state " << l << ' ' << m << ' ' << r << '\n';
 }
 
-void drawText(FILE *out, const char *text)
+void drawText(TraceWriter &out, const char *text)
 {
-    fprintf(out, "print %s\n", text);
+    out << "print " << text << '\n';
 }
 
-void endOfSlide(FILE *out)
+void endOfSlide(TraceWriter &out)
 {
-    fprintf(out, "end\n");
+    out << "end\n";
 }
 
-void endOfStep(FILE *out)
+void endOfStep(TraceWriter &out)
 {
-    fprintf(out, "wait\n");
+    out << "wait\n";
 }
 
 bool isConvex(const Polygon &poly)
@@ -289,24 +513,308 @@ bool isConvex(const Polygon &poly)
     return 1;
 }
 
-Polygon genLargePolygon(int vcnt, double radius)                                               
+Polygon genLargePolygon(int vcnt, double radius)
+{
+    return genLargePolygon(vcnt, radius, (unsigned long long) rand() * (RAND_MAX + 1ull) + (unsigned long long) rand());
+}
+
+// Splits sorted distinct coordinates into two chains from the minimal one to the maximal one
+// and returns differences of consecutive coordinates of both chains. They are nonzero and their sum is zero
+inline vector <int> randomChains(const vector <int> &coords, mt19937_64 &random)
+{
+    vector <int> result;
+    int first = coords[0], second = coords[0];
+    for (int i = 1; i + 1 < (int) coords.size(); i++)
+    {
+        if (random() & 1)
+        {
+            result.push_back(coords[i] - first);
+            first = coords[i];
+        }
+        else
+        {
+            result.push_back(second - coords[i]);
+            second = coords[i];
+        }
+    }
+    result.push_back(coords.back() - first);
+    result.push_back(second - coords.back());
+    return result;
+}
+
+// Returns cnt distinct sorted random numbers from [-radius, radius]
+inline vector <int> randomDistinct(int cnt, int radius, mt19937_64 &random)
+{
+    vector <int> result;
+    while ((int) result.size() < cnt)
+    {
+        while ((int) result.size() < cnt)
+            result.push_back((int) (random() % (2ull * (unsigned) radius + 1)) - radius);
+        sort(result.begin(), result.end());
+        result.erase(unique(result.begin(), result.end()), result.end());
+    }
+    return result;
+}
+
+Polygon genLargePolygon(int vcnt, double radius, unsigned long long seed)
+{
+    mt19937_64 random(seed);
+    // Random sides have enough distinct directions only if radius is about vcnt^1.5 / 4 at least
+    long long minRadius = (long long) ceil(pow(vcnt, 1.5) / 4);
+    assert(vcnt >= 3 && minRadius < (1<<30));
+    int r = (int) max((double) minRadius, min(radius, (double) ((1<<30) - 1)));
+    // Parallel sides are merged, so a few more sides are generated than needed
+    int extra = vcnt / 64 + 1;
+    while (1)
+    {
+        if (vcnt + extra > 2 * r + 1)
+        {
+            // All coordinates are taken and sides are too short to have vcnt directions
+            assert(r < (1<<29));
+            r *= 2;
+            extra = vcnt / 64 + 1;
+        }
+        int cnt = vcnt + extra;
+        vector <int> dx = randomChains(randomDistinct(cnt, r, random), random);
+        vector <int> dy = randomChains(randomDistinct(cnt, r, random), random);
+        vector <Point> sides;
+        for (int i = 0; i < cnt; i++)
+        {
+            swap(dy[i], dy[i + (int) (random() % (unsigned long long) (cnt - i))]);
+            sides.push_back(Point(dx[i], dy[i]));
+        }
+        sort(sides.begin(), sides.end(), compareByAngle);
+        vector <Point> merged;
+        for (auto &side : sides)
+        {
+            if (!merged.empty() && merged.back() % side == 0 && merged.back() * side > 0)
+                merged.back() += side;
+            else
+                merged.push_back(side);
+        }
+        if ((int) merged.size() < vcnt)
+        {
+            // Next time there will be about as many parallel sides, so twice as many are added
+            extra += 2 * (cnt - (int) merged.size());
+            continue;
+        }
+        // Sum of consecutive sides lies strictly between them by angle, so sides are joined at
+        // random till there are vcnt of them and the polygon stays strictly convex.
+        // The last side is never joined to the first one, so the order is kept
+        vector <char> join(merged.size(), 0);
+        for (int left = (int) merged.size() - vcnt; left > 0; )
+        {
+            int i = (int) (random() % (merged.size() - 1));
+            if (!join[i])
+            {
+                join[i] = 1;
+                left--;
+            }
+        }
+        vector <Point> points(1, Point(0, 0));
+        Point side(0, 0);
+        for (int i = 0; i + 1 < (int) merged.size(); i++)
+        {
+            side += merged[i];
+            if (!join[i])
+            {
+                points.push_back(points.back() + side);
+                side = Point(0, 0);
+            }
+        }
+        Point low = points[0], high = points[0];
+        for (auto &p : points)
+        {
+            low = Point(min(low.x, p.x), min(low.y, p.y));
+            high = Point(max(high.x, p.x), max(high.y, p.y));
+        }
+        Point shift((int) (((long long) low.x + high.x) / 2), (int) (((long long) low.y + high.y) / 2));
+        for (auto &p : points)
+            p -= shift;
+        return Polygon(points);
+    }
+}
+
+void hullVertices(vector <Point> &points)
+{
+    sort(points.begin(), points.end(), [](const Point &first, const Point &second)
+    {
+        return first.x < second.x || (first.x == second.x && first.y < second.y);
+    });
+    points.erase(unique(points.begin(), points.end()), points.end());
+    if (points.size() < 3)
+        return;
+    // Monotone chain: lower hull from left to right, then upper hull from right to left.
+    // Vertex is popped when it is not strictly to the right of the chain, so points
+    // on sides are dropped
+    vector <Point> hull(2 * points.size());
+    int size = 0;
+    for (int i = 0; i < (int) points.size(); i++)
+    {
+        while (size >= 2 && (hull[size - 1] - hull[size - 2]) % (points[i] - hull[size - 2]) <= 0)
+            size--;
+        hull[size++] = points[i];
+    }
+    for (int i = (int) points.size() - 2, lower = size + 1; i >= 0; i--)
+    {
+        while (size >= lower && (hull[size - 1] - hull[size - 2]) % (points[i] - hull[size - 2]) <= 0)
+            size--;
+        hull[size++] = points[i];
+    }
+    // The first point is added twice
+    hull.resize(size - 1);
+    points.swap(hull);
+}
+
+Polygon convexHull(vector <Point> points, bool *ok)
+{
+    hullVertices(points);
+    setOk(ok, points.size() >= 3);
+    return Polygon(points);
+}
+
+void antipodalPairs(const Polygon &poly, vector <pair <int, int> > &result)
 {
-    vector <Point> result;
-    while (result.size() == 0 || !isConvex(result))
+    // Supporting lines parallel to side i go through its ends and the vertex j that is the
+    // farthest from it, or the side j if it is parallel to side i. Every antipodal pair
+    // appears at such position of calipers, and j only moves forward while i goes around
+    result.clear();
+    int n = poly.size();
+    auto add = [&](int a, int b)
+    {
+        a %= n, b %= n;
+        result.push_back(make_pair(min(a, b), max(a, b)));
+    };
+    for (int i = 0, j = 1; i < n; i++)
     {
-        result.clear();
-        double dx = max(0.5, (double) rand() / RAND_MAX * 2);
-        double dy = max(0.5, (double) rand() / RAND_MAX * 2);
-        for (int i = 0; i < vcnt; i++)
+        Point side = poly[i + 1] - poly[i];
+        j = max(j, i + 1);
+        while (side % (poly[j + 1] - poly[j]) > 0 || (side % (poly[j + 1] - poly[j]) == 0 && side * (poly[j + 1] - poly[j]) > 0))
+            j++;
+        add(i, j);
+        add(i + 1, j);
+        if (side % (poly[j + 1] - poly[j]) == 0)
         {
-            double angle = (double) rand() / RAND_MAX * 2 * 3.1415;
-            result.push_back(Point(int(cos(angle) * radius * dx), int(sin(angle) * radius * dy)));    
+            add(i, j + 1);
+            add(i + 1, j + 1);
         }
-        sort(result.begin(), result.end(), compareByAngle);
     }
+    sort(result.begin(), result.end());
+    result.erase(unique(result.begin(), result.end()), result.end());
+}
+
+double diameter(const Polygon &poly, int *first, int *second)
+{
+    vector <pair <int, int> > pairs;
+    antipodalPairs(poly, pairs);
+    pair <int, int> best = pairs[0];
+    for (auto &p : pairs)
+        if ((poly[p.first] - poly[p.second]).len2() > (poly[best.first] - poly[best.second]).len2())
+            best = p;
+    if (first)
+        *first = best.first;
+    if (second)
+        *second = best.second;
+    return (poly[best.first] - poly[best.second]).len();
+}
+
+// Calls check(i, left, far, right) for every side i of polygon, where far is the vertex that
+// is the farthest from the side and left and right are the vertices with minimal and maximal
+// projection on it. All four calipers go around polygon once, so it takes O(n)
+template <class Check> inline void rotateCalipers(const Polygon &poly, Check check)
+{
+    int n = poly.size();
+    for (int i = 0, right = 1, far = 1, left = 1; i < n; i++)
+    {
+        Point side = poly[i + 1] - poly[i];
+        right = max(right, i + 1);
+        while ((poly[right + 1] - poly[right]) * side > 0)
+            right++;
+        far = max(far, right);
+        while (side % (poly[far + 1] - poly[far]) > 0)
+            far++;
+        left = max(left, far);
+        while ((poly[left + 1] - poly[left]) * side < 0)
+            left++;
+        check(i, left, far, right);
+    }
+}
+
+double width(const Polygon &poly, int *side, int *vertex)
+{
+    long double best = -1;
+    rotateCalipers(poly, [&](int i, int, int far, int)
+    {
+        Point dir = poly[i + 1] - poly[i];
+        long double current = (long double) (dir % (poly[far] - poly[i])) / sqrtl((long double) dir.len2());
+        if (best < 0 || current < best)
+        {
+            best = current;
+            if (side)
+                *side = i;
+            if (vertex)
+                *vertex = far % poly.size();
+        }
+    });
+    return (double) best;
+}
+
+// Rectangle with side on the line through side i of polygon, see rotateCalipers.
+// Its size along the side is length and across the side is height
+inline vector <PointDouble> rectangle(const Polygon &poly, int i, int left, int far, int right)
+{
+    Point dir = poly[i + 1] - poly[i];
+    long double len = sqrtl((long double) dir.len2());
+    long double ux = dir.x / len, uy = dir.y / len;
+    long double from = (long double) ((poly[left] - poly[i]) * dir) / len;
+    long double to = (long double) ((poly[right] - poly[i]) * dir) / len;
+    long double height = (long double) (dir % (poly[far] - poly[i])) / len;
+    vector <PointDouble> result;
+    // Normal (-uy, ux) is directed inside polygon, so corners go counter-clockwise
+    for (auto corner : {make_pair(from, 0.0l), make_pair(to, 0.0l), make_pair(to, height), make_pair(from, height)})
+        result.push_back(PointDouble((double) (poly[i].x + ux * corner.first - uy * corner.second),
+                                     (double) (poly[i].y + uy * corner.first + ux * corner.second)));
     return result;
 }
 
+vector <PointDouble> minAreaRectangle(const Polygon &poly)
+{
+    // Rectangle of minimal area has a side on the line through a side of polygon
+    long double best = -1;
+    int bestSide = 0, bestLeft = 0, bestFar = 0, bestRight = 0;
+    rotateCalipers(poly, [&](int i, int left, int far, int right)
+    {
+        Point dir = poly[i + 1] - poly[i];
+        long double current = (long double) ((poly[right] - poly[left]) * dir) *
+                              (long double) (dir % (poly[far] - poly[i])) / (long double) dir.len2();
+        if (best < 0 || current < best)
+        {
+            best = current;
+            bestSide = i, bestLeft = left, bestFar = far, bestRight = right;
+        }
+    });
+    return rectangle(poly, bestSide, bestLeft, bestFar, bestRight);
+}
+
+vector <PointDouble> minPerimeterRectangle(const Polygon &poly)
+{
+    // Rectangle of minimal perimeter has a side on the line through a side of polygon too
+    long double best = -1;
+    int bestSide = 0, bestLeft = 0, bestFar = 0, bestRight = 0;
+    rotateCalipers(poly, [&](int i, int left, int far, int right)
+    {
+        Point dir = poly[i + 1] - poly[i];
+        long double current = ((long double) ((poly[right] - poly[left]) * dir) +
+                               (long double) (dir % (poly[far] - poly[i]))) / sqrtl((long double) dir.len2());
+        if (best < 0 || current < best)
+        {
+            best = current;
+            bestSide = i, bestLeft = left, bestFar = far, bestRight = right;
+        }
+    });
+    return rectangle(poly, bestSide, bestLeft, bestFar, bestRight);
+}
+
 bool isOnSegment(const Point &a, const Segment &segment)
 {
     return (a - segment.first) % (segment.second - segment.first) == 0 &&
@@ -324,11 +832,41 @@ bool isIntersection(const Ray &ray, const Segment &segment)
 
 bool isIntersection(const Line &line, const Segment &segment)
 {
-    return sign(segment.first * line.normal() + line.c) * sign(segment.second * line.normal() + line.c) <= 0;
+    return line.side(segment.first) * line.side(segment.second) <= 0;
+}
+
+// Same as isInsideLinear, but all sides are processed without branches and
+// the loop is rerun with early exits only if point can lie on the boundary
+inline bool isInsideLinearSoA(const Point &a, const Polygon &poly)
+{
+    const int *x = poly.xs(), *y = poly.ys();
+    const long long dirX = 1<<30, dirY = (1<<30) - 1;
+    int n = poly.size(), cnt = 0, boundary = 0;
+    for (int i = 0; i < n; i++)
+    {
+        long long x1 = x[i] - a.x, y1 = y[i] - a.y, x2 = x[i + 1] - a.x, y2 = y[i + 1] - a.y;
+        long long cross = x1 * y2 - y1 * x2;
+        boundary |= (cross == 0 && x1 * x2 + y1 * y2 <= 0) | (y1 == 0 && y2 == 0);
+        int first = sign(dirX * y1 - dirY * x1), second = sign(dirX * y2 - dirY * x2);
+        int side = sign(cross), dir = sign(dirX * (y2 - y1) - dirY * (x2 - x1));
+        cnt += first * second <= 0 && side * dir >= 0;
+    }
+    if (!boundary)
+        return cnt % 2 == 1;
+    for (int i = 0; i < n; i++)
+    {
+        if (a.y == y[i] && a.y == y[i + 1])
+            return isOnSegment(a, Segment(poly[i], poly[i + 1]));
+        if (isOnSegment(a, Segment(poly[i], poly[i + 1])))
+            return 1;
+    }
+    return cnt % 2 == 1;
 }
 
 bool isInsideLinear(const Point &a, const Polygon &poly)
 {
+    if (poly.hasSoA())
+        return isInsideLinearSoA(a, poly);
     int cnt = 0;
     for (int i = 0; i < poly.size(); i++)
     {
@@ -343,126 +881,128 @@ bool isInsideLinear(const Point &a, const Polygon &poly)
     return cnt % 2 == 1;
 }
 
-inline void drawBinSearchState(FILE *out, const Polygon &poly, int l, int m, int r)
+template <class Tracer> inline void drawIsInsideState(Tracer &tracer, const Point &point, const Polygon &poly, int l, int m, int r)
 {
+    tracer.drawBinSearchState(poly, l, m, r);
+    tracer.drawPoint(point, "point");
     if (l != -1)
-        drawPoint(out, poly[l], "l");
-    
-    if (r != -1)            
-        drawPoint(out, poly[r], "r");
-
-    if (m != -1)
-        drawPoint(out, poly[m], "m");
-
-    for (int i = 0; i < poly.size(); i++)
+        tracer.drawSegment(poly[0], poly[l], "red");
+    if (r != -1)
+        tracer.drawSegment(poly[0], poly[r], "red");
+}
+
+// Narrows the range of binary search in isInside with the angular index of polygon.
+// The range is checked, so it is left as is if it is not correct because of rounding.
+inline void narrowFan(const Point &point, const Polygon &poly, int &l, int &r)
+{
+    Point dir = point - poly[0];
+    if (dir == Point(0, 0))
+        return;
+    int from, to;
+    poly.fanIndex.range(pseudoAngle(dir), from, to);
+    // Element i of the fan is vertex i + 1
+    int newL = from, newR = to + 1;
+    if ((newL == 0 || dir % (poly[newL] - poly[0]) <= 0) && 
+        (newR == poly.size() || dir % (poly[newR] - poly[0]) > 0))
     {
-        if (i >= l && i < r)
-            drawSegment(out, poly[i], poly[i + 1], "red");
-        else
-            drawSegment(out, poly[i], poly[i + 1], "black");
-        drawPoint(out, poly[i]);
+        l = newL;
+        r = newR;
     }
 }
 
-inline void drawIsInsideState(FILE *out, const Point &point, const Polygon &poly, int l, int m, int r)
+// Checks that point lies in triangle poly[0], poly[l], poly[l + 1] of the fan from poly[0],
+// where l is the last vertex such that point is not to the left of ray from poly[0] to it.
+// Last wedge is not a triangle, point lies in it only if it is on side poly[l], poly[0]
+inline bool isInsideFanTriangle(const Point &point, const Polygon &poly, int l)
 {
-    drawBinSearchState(out, poly, l, m, r);
-    drawPoint(out, point, "point");
-    if (l != -1)
-        drawSegment(out, poly[0], poly[l], "red");
-    if (r != -1)
-        drawSegment(out, poly[0], poly[r], "red");
+    if (l == poly.size() - 1)
+        return isOnSegment(point, Segment(poly[l], poly[0]));
+    return (point - poly[0]) % (poly[l] - poly[0]) <= 0 && 
+           (point - poly[l]) % (poly[l + 1] - poly[l]) <= 0 &&
+           (point - poly[l + 1]) % (poly[0] - poly[l + 1]) <= 0;
 }
 
-bool isInside(const Point &point, const Polygon &poly, FILE *out)
+template <class Tracer> bool isInside(const Point &point, const Polygon &poly, Tracer &tracer)
 {
-    int l = 0, r = poly.size(), m;
-    #ifdef DEBUG
-    int cnt = 0;
-    #endif        
-    if (out)
+    StatsScope stats(STATS_IS_INSIDE, poly.size(), 0);
+    if (!Tracer::enabled && !poly.bounds.contains(point))
     {
-        drawIsInsideState(out, point, poly, -1, -1, -1);
-        drawText(out, "Проверка на принадлежность точки многоугольнику\nwait");
-        drawText(out, "Хотим найти две вершины такие, что точка лежит между векторами,\\n\
-проведенными из первой вершины в эти две"); 
-        endOfStep(out);
-        drawText(out, "Будем искать бинпоиском ближайшую к данной точке по углу вершину.");
-        endOfSlide(out);                                                                                         
-        drawIsInsideState(out, point, poly, l, -1, r);
-        drawText(out, "Изначально границы бинпоиска покрывают весь многоугольник.");
-        endOfSlide(out);
+        stats.event(STATS_OUTSIDE_BOUNDS);
+        return 0;
     }
-    while (r - l > 1)
+    int l = 0, r = poly.size();
+    if (!Tracer::enabled && poly.hasAngularIndex())
     {
-        #ifdef DEBUG
-        cnt++;
-        assert((1<<(cnt - 1)) <= poly.size());
-        #endif
-        m = (l + r) / 2;
-        if (out)
-        {
-            drawIsInsideState(out, point, poly, l, m, r);
-            endOfStep(out);            
-            drawText(out, "Смотрим на векторное произведение вектора из нулевой точки многоугольника до\\nвершины m и вектора до данной точки");
-            drawAngle(out, poly[0], point, poly[m], 1);
-            endOfStep(out);                        
-        }
-        if ((point - poly[0]) % (poly[m] - poly[0]) <= 0)
-        {
-            if (out)
-                drawText(out, "Так как точка лежит правее вершины (по обходу против часовой стрелки),\\n\
-то двигаем левый указатель");
-            l = m;
-        }
-        else
-        {
-            if (out)
-                drawText(out, "Так как точка лежит левее вершины (по обходу против часовой стрелки),\\n\
-то двигаем правый указатель");
-            r = m;
-        }
-        if (out)
-            endOfSlide(out);
+        stats.event(STATS_ANGULAR_INDEX);
+        narrowFan(point, poly, l, r);
     }
-    if (out)
+    if (Tracer::enabled)
     {
-        drawIsInsideState(out, point, poly, l, -1, r);        
-        endOfStep(out);
+        drawIsInsideState(tracer, point, poly, -1, -1, -1);
+        tracer.drawText("Проверка на принадлежность точки многоугольнику\nwait");
+        tracer.drawText("Хотим найти две вершины такие, что точка лежит между векторами,\\n\
+проведенными из первой вершины в эти две"); 
+        tracer.endOfStep();
+        tracer.drawText("Будем искать бинпоиском ближайшую к данной точке по углу вершину.");
+        tracer.endOfSlide();                                                                                         
+        drawIsInsideState(tracer, point, poly, l, -1, r);
+        tracer.drawText("Изначально границы бинпоиска покрывают весь многоугольник.");
+        tracer.endOfSlide();
     }
-    bool result;
-    if (l == poly.size() - 1)
-        result = isOnSegment(point, Segment(poly[l], poly[0]));
-    else
-        result = (point - poly[0]) % (poly[l] - poly[0]) <= 0 && 
-        (point - poly[l]) % (poly[l + 1] - poly[l]) <= 0 &&
-        (point - poly[l + 1]) % (poly[0] - poly[l + 1]) <= 0;
-    if (out)
+    l = fanSearch(l, r, [&poly, point](int m)
+    {
+        return (point - poly[0]) % (poly[m] - poly[0]);
+    },
+    [&](int l, int m, int r)
+    {
+        drawIsInsideState(tracer, point, poly, l, m, r);
+    },
+    [&](int m)
+    {
+        tracer.drawAngle(poly[0], point, poly[m], 1);
+    }, stats, tracer);
+    if (Tracer::enabled)
+    {
+        drawIsInsideState(tracer, point, poly, l, -1, l + 1);
+        tracer.endOfStep();
+    }
+    bool result = isInsideFanTriangle(point, poly, l);
+    if (Tracer::enabled)
     {
         if (result)
-            drawText(out, "Так как точка лежит внутри треугольника, то она лежит и внутри многоугольника");
+            tracer.drawText("Так как точка лежит внутри треугольника, то она лежит и внутри многоугольника");
         else
-            drawText(out, "Так как точка лежит вне треугольника, то она лежит и снаружи многоугольника");
+            tracer.drawText("Так как точка лежит вне треугольника, то она лежит и снаружи многоугольника");
     }
+    return result;
 }
 
-inline int findIntersection(const Point &a, const Polygon &poly, int from, int to, int signOfCompare)
+bool isInside(const Point &point, const Polygon &poly, FILE *out)
 {
-    int l, r, m;
+    if (out)
+    {
+        SlideTracer tracer(out);
+        return isInside(point, poly, tracer);
+    }
+    NullTracer tracer;
+    return isInside(point, poly, tracer);
+}
+
+// Iterations are added to stats of the caller, which makes two such searches
+inline int findIntersection(const Point &a, const Polygon &poly, int from, int to, int signOfCompare, StatsScope &stats)
+{
+    int l, r, m, n = poly.size();
+    // Only ordinates are compared, so with separate arrays half as much memory is read
+    const int *y = poly.hasSoA() ? poly.ys() : NULL;
     l = from, r = to;
     if (l >= r)
-        r += poly.size();
-    #ifdef DEBUG
-    int cnt = 0;
-    #endif
+        r += n;
     while (r - l > 1)
     {
-        #ifdef DEBUG
-        cnt++;
-        assert((1<<(cnt - 1)) <= poly.size());
-        #endif
+        stats.iteration();
         m = (l + r) / 2;
-        if (poly[m].y * signOfCompare >= a.y * signOfCompare)
+        int my = y ? y[m < n ? m : m - n] : poly[m].y;
+        if (my * signOfCompare >= a.y * signOfCompare)
             l = m;
         else
             r = m;
@@ -478,18 +1018,279 @@ inline int findIntersection(const Point &a, const Polygon &poly, int from, int t
 
 bool isInsideBS2(const Point &a, const Polygon &poly)
 {
-    int cnt = findIntersection(a, poly, poly.upmost, poly.downmost, 1) +
-              findIntersection(a, poly, poly.downmost, poly.upmost, -1);
+    // Two binary searches over chains of at most size() vertices
+    StatsScope stats(STATS_IS_INSIDE_BS2, 1ll * poly.size() * poly.size(), 0);
+    if (!poly.bounds.contains(a))
+    {
+        stats.event(STATS_OUTSIDE_BOUNDS);
+        return 0;
+    }
+    int cnt = findIntersection(a, poly, poly.upmost, poly.downmost, 1, stats) +
+              findIntersection(a, poly, poly.downmost, poly.upmost, -1, stats);
     if (cnt >= 3)
         return 1;
     return cnt == 1;
 }
 
+// The same binary search as in isInside, but it makes the same number of iterations
+// for every point, so several points can be processed at once.
+inline bool isInsideBranchless(const Point &point, const Polygon &poly)
+{
+    const Point *p = poly.data();
+    int n = poly.size(), l = 0;
+    Point dir = point - p[0];
+    for (int len = n; len > 1; )
+    {
+        int half = len / 2;
+        if (dir % (p[l + half] - p[0]) <= 0)
+            l += half;
+        len -= half;
+    }
+    if (l == n - 1)
+        return isOnSegment(point, Segment(p[l], p[0]));
+    return dir % (p[l] - p[0]) <= 0 &&
+           (point - p[l]) % (p[l + 1] - p[l]) <= 0 &&
+           (point - p[l + 1]) % (p[0] - p[l + 1]) <= 0;
+}
+
+#ifdef GEOMETRY_AVX2
+// Every 64-bit lane holds a point or a vector as two 32-bit coordinates (x in the low half).
+// Coordinates are bounded by 2^30, so differences of them still fit in 32 bits.
+__attribute__((target("avx2")))
+inline __m256i cross4(__m256i a, __m256i b)
+{
+    return _mm256_sub_epi64(_mm256_mul_epi32(a, _mm256_srli_epi64(b, 32)), 
+                            _mm256_mul_epi32(_mm256_srli_epi64(a, 32), b));
+}
+
+__attribute__((target("avx2")))
+inline __m256i dot4(__m256i a, __m256i b)
+{
+    return _mm256_add_epi64(_mm256_mul_epi32(a, b), 
+                            _mm256_mul_epi32(_mm256_srli_epi64(a, 32), _mm256_srli_epi64(b, 32)));
+}
+
+// Processes points by groups of four lanes and returns the number of processed points
+__attribute__((target("avx2")))
+int isInsideAVX2(const Point *points, int count, const Polygon &poly, bool *result)
+{
+    const long long *p = (const long long *) poly.data();
+    int n = poly.size();
+    const __m256i zero = _mm256_setzero_si256(), one = _mm256_set1_epi64x(1);
+    const __m256i p0 = _mm256_set1_epi64x(p[0]), last = _mm256_set1_epi64x(n - 1);
+    int i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m256i point = _mm256_loadu_si256((const __m256i *) (points + i));
+        __m256i dir = _mm256_sub_epi32(point, p0);
+        __m256i l = zero;
+        for (int len = n; len > 1; )
+        {
+            int half = len / 2;
+            __m256i m = _mm256_add_epi64(l, _mm256_set1_epi64x(half));
+            __m256i pm = _mm256_i64gather_epi64((const long long *) p, m, 8);
+            __m256i right = _mm256_cmpgt_epi64(cross4(dir, _mm256_sub_epi32(pm, p0)), zero);
+            l = _mm256_blendv_epi8(m, l, right);
+            len -= half;
+        }
+        __m256i isLast = _mm256_cmpeq_epi64(l, last);
+        __m256i l1 = _mm256_andnot_si256(isLast, _mm256_add_epi64(l, one));
+        __m256i pl = _mm256_i64gather_epi64((const long long *) p, l, 8);
+        __m256i pl1 = _mm256_i64gather_epi64((const long long *) p, l1, 8);
+        __m256i outside = _mm256_or_si256(
+                _mm256_cmpgt_epi64(cross4(dir, _mm256_sub_epi32(pl, p0)), zero),
+                _mm256_or_si256(
+                _mm256_cmpgt_epi64(cross4(_mm256_sub_epi32(point, pl), _mm256_sub_epi32(pl1, pl)), zero),
+                _mm256_cmpgt_epi64(cross4(_mm256_sub_epi32(point, pl1), _mm256_sub_epi32(p0, pl1)), zero)));
+        // On the last side of the fan the point should lie on segment (poly[n - 1], poly[0])
+        __m256i outsideSegment = _mm256_or_si256(
+                _mm256_cmpgt_epi64(zero, dot4(_mm256_sub_epi32(point, pl), _mm256_sub_epi32(pl1, pl))),
+                _mm256_cmpgt_epi64(zero, dot4(_mm256_sub_epi32(point, pl1), _mm256_sub_epi32(pl, pl1))));
+        outside = _mm256_or_si256(outside, _mm256_and_si256(isLast, outsideSegment));
+        int mask = _mm256_movemask_pd(_mm256_castsi256_pd(outside));
+        for (int j = 0; j < 4; j++)
+            result[i + j] = !((mask >> j) & 1);
+    }
+    return i;
+}
+#endif
+
+void isInsideBatch(const Point *points, int count, const Polygon &poly, bool *result)
+{
+    int i = 0;
+    #ifdef GEOMETRY_AVX2
+    if (__builtin_cpu_supports("avx2"))
+        i = isInsideAVX2(points, count, poly, result);
+    #endif
+    for (; i < count; i++)
+        result[i] = isInsideBranchless(points[i], poly);
+}
+
+// Returns the first d in [0, limit] such that pred(d) is false.
+// pred(0) should be true and pred should be true on a prefix of [0, limit).
+// It checks pred(1), pred(3), pred(7), ... and then makes binary search,
+// so it needs O(log d) checks.
+template <class Pred> inline int gallop(Pred pred, int limit)
+{
+    int good = 0, step = 1;
+    while (good + step < limit && pred(good + step))
+    {
+        good += step;
+        step *= 2;
+    }
+    int bad = min(good + step, limit);
+    while (bad - good > 1)
+    {
+        int m = (good + bad) / 2;
+        if (pred(m))
+            good = m;
+        else
+            bad = m;
+    }
+    return bad;
+}
+
+void isInsideSorted(const Point *points, int count, const Polygon &poly, bool *result)
+{
+    // Points that lie in the angle of polygon at poly[0] are sorted by angle around it,
+    // then vertex l of isInside grows with angle and is found by one pass over the fan
+    int n = poly.size();
+    Point first = poly[1] - poly[0], last = poly[n - 1] - poly[0];
+    // Vector from poly[0] to point, index of point and 1 if vector is opposite to first.
+    // Angle of polygon is at most PI, so other vectors are compared by vector multiplication
+    struct Entry
+    {
+        Point v;
+        int index, opposite;
+    };
+    vector <Entry> order;
+    order.reserve(count);
+    for (int i = 0; i < count; i++)
+    {
+        Entry entry;
+        entry.v = points[i] - poly[0];
+        entry.index = i;
+        result[i] = entry.v == Point(0, 0);
+        if (!result[i] && first % entry.v >= 0 && entry.v % last >= 0)
+        {
+            entry.opposite = first % entry.v == 0 && first * entry.v < 0;
+            order.push_back(entry);
+        }
+    }
+    sort(order.begin(), order.end(), [](const Entry &a, const Entry &b)
+    {
+        if (a.opposite != b.opposite)
+            return a.opposite < b.opposite;
+        return a.v % b.v > 0;
+    });
+    // Vertex l is moved by galloping, so for few points the fan is not passed whole
+    int l = 0;
+    for (auto &entry : order)
+    {
+        const Point &point = points[entry.index];
+        l += gallop([&](int j)
+        {
+            return (point - poly[0]) % (poly[l + j] - poly[0]) <= 0;
+        }, n - l) - 1;
+        result[entry.index] = isInsideFanTriangle(point, poly, l);
+    }
+}
+
+// 0 for vectors with angle in [-PI, 0) and 1 for [0, PI)
+inline int halfOfPlane(const Point &a)
+{
+    return a.y > 0 || (a.y == 0 && a.x >= 0);
+}
+
 bool compareByAngle(const Point &first, const Point &second) 
 {
-    if (sign(first.y) * sign(second.y) < 0)
-        return first.y == second.y ? first.x < second.x : first.y < second.y;
-    return first.y == 0 && second.y == 0 ? first.x < second.x : first % second > 0;
+    if (halfOfPlane(first) != halfOfPlane(second))
+        return halfOfPlane(first) < halfOfPlane(second);
+    return first % second > 0;
+}
+
+inline double pseudoAngle(double x, double y)
+{
+    double p = y / (abs(x) + abs(y));
+    if (x >= 0)
+        return y >= 0 ? p : 4 + p;
+    return 2 - p;
+}
+
+double pseudoAngle(const Point &v)
+{
+    return pseudoAngle(v.x, v.y);
+}
+
+// Returns vertex with maximal projection on dir found with the angular index 
+// of polygon or -1 if the index gives too many candidates
+inline int maximalPointIndexed(const Point &dir, const Polygon &poly)
+{
+    if (dir == Point(0, 0))
+        return -1;
+    int from, to;
+    // Sides before the maximal vertex go along dir, so they have smaller angle than normal to dir
+    poly.sideIndex.range(pseudoAngle(Point(-dir.y, dir.x)), from, to);
+    if (to - from > 32)
+        return -1;
+    for (int i = from; i <= to; i++)
+        if ((poly[i] - poly[i - 1]) * dir >= 0 && (poly[i + 1] - poly[i]) * dir <= 0)
+            return i % poly.size();
+    return -1;
+}
+
+// Returns tangent vertex searching from vertex k. 
+// side is 1 for left tangent and -1 for right tangent.
+// Sides of polygon that are visible from point form a segment of the polygon, left tangent
+// is its first vertex and right tangent is its last vertex. Walking from vertex k to the tangent
+// the sides keep their visibility and their vertices keep the side of line from point to poly[k].
+// So the predicate is true on a prefix of walk and galloping search can be used.
+// The walk does not reach the neighbour of k from the other side, because it can lie on
+// the line from point to poly[k] too.
+inline int tangentFrom(const Point &point, const Polygon &poly, int k, int side)
+{
+    int n = poly.size() - 1, result;
+    Point base = poly[k] - point;
+    if (side == 1)
+    {
+        // Left tangent is the vertex after the last side that is not visible
+        if ((poly[k + 1] - point) % base > 0)
+            result = k + 1 - gallop([&](int d) { 
+                return (poly[k - d + 1] - point) % (poly[k - d] - point) > 0 && base % (poly[k - d] - point) >= 0; 
+            }, n);
+        else
+            result = k + gallop([&](int d) { 
+                return (poly[k + d + 1] - point) % (poly[k + d] - point) <= 0 && base % (poly[k + d] - point) >= 0; 
+            }, n);
+    }
+    else
+    {
+        // Right tangent is the vertex after the last side that is visible or collinear to point
+        if ((poly[k + 1] - point) % base >= 0)
+            result = k + gallop([&](int d) { 
+                return (poly[k + d + 1] - point) % (poly[k + d] - point) >= 0 && base % (poly[k + d] - point) <= 0; 
+            }, n);
+        else
+            result = k + 1 - gallop([&](int d) { 
+                return (poly[k - d + 1] - point) % (poly[k - d] - point) < 0 && base % (poly[k - d] - point) <= 0; 
+            }, n);
+    }
+    return (result % poly.size() + poly.size()) % poly.size();
+}
+
+// Returns tangent vertex searching from the vertex that would be tangent if polygon
+// were a circle. This vertex is found with the angular index of polygon.
+inline int tangentIndexed(const Point &point, const Polygon &poly, int side)
+{
+    double dx = poly.center.x - point.x, dy = poly.center.y - point.y;
+    double dist = sqrt(dx * dx + dy * dy);
+    double s = dist > poly.radius ? poly.radius / dist * side : side, c = sqrt(1 - s * s);
+    // Direction from point to the tangent vertex is (dx, dy) rotated by arcsin(s)
+    // Sides near the tangent vertex are parallel to the tangent line. They go from point 
+    // for right tangent and to point for left tangent
+    int from, to;
+    poly.sideIndex.range(pseudoAngle((dy * s - dx * c) * side, (-dx * s - dy * c) * side), from, to);
+    return tangentFrom(point, poly, from, side);
 }
 
 int leftTangentLinear(const Point &point, const Polygon &poly)
@@ -512,225 +1313,98 @@ int rightTangentLinear(const Point &point, const Polygon &poly)
     return 0;
 }
 
-inline void drawTangentState(FILE *out, const Point &point, const Polygon &poly, int l, int m, int r, int ang1 = -1, int ang2 = -1)
+template <class Tracer> inline void drawTangentState(Tracer &tracer, const Point &point, const Polygon &poly, int l, int m, int r, int ang1 = -1, int ang2 = -1)
 {
-    drawBinSearchState(out, poly, l, m, r);
-    drawPoint(out, point, "point");
+    tracer.drawBinSearchState(poly, l, m, r);
+    tracer.drawPoint(point, "point");
     if (ang1 != -1 && ang2 != -1)
-        drawAngle(out, point, poly[ang1], poly[ang2], 1);                                    
+        tracer.drawAngle(point, poly[ang1], poly[ang2], 1);                                    
 }
 
-int leftTangent(const Point &point, const Polygon &poly, FILE *out)
+template <class Tracer> int leftTangent(const Point &point, const Polygon &poly, Tracer &tracer)
 {
-    int l, m, r;
-    l = 0, r = poly.size();
-    #ifdef DEBUG
-    int cnt = 0;
-    #endif
-    
-    if (out)
+    StatsScope stats(STATS_LEFT_TANGENT, poly.size(), 2);
+    if (!Tracer::enabled && poly.hasAngularIndex())
     {
-        drawTangentState(out, point, poly, -1, -1, -1);
-        drawText(out, "Поиск левой касательной из точки к многоугольнику");
-        endOfStep(out);
-        drawText(out, "Точка касания это такая вершина многоугольника\\n\
+        stats.event(STATS_ANGULAR_INDEX);
+        return tangentIndexed(point, poly, 1);
+    }
+    if (Tracer::enabled)
+    {
+        drawTangentState(tracer, point, poly, -1, -1, -1);
+        tracer.drawText("Поиск левой касательной из точки к многоугольнику");
+        tracer.endOfStep();
+        tracer.drawText("Точка касания это такая вершина многоугольника\\n\
 вектор из данной точки до которой имеет наибольший угол");
-        endOfStep(out);
-        drawText(out, "Поскольку функция угла является выпуклой, ее максимум\\n\
+        tracer.endOfStep();
+        tracer.drawText("Поскольку функция угла является выпуклой, ее максимум\\n\
 можно найти бинпоиском по производной");
-        endOfSlide(out);
-        drawTangentState(out, point, poly, l, -1, r);
-        drawText(out, "Изначально границы бинпоиска покрывают весь многоугольник.");
-        endOfSlide(out);
+        tracer.endOfSlide();
+        drawTangentState(tracer, point, poly, 0, -1, poly.size());
+        tracer.drawText("Изначально границы бинпоиска покрывают весь многоугольник.");
+        tracer.endOfSlide();
     }
-    
-    while (r - l > 1)
+
+    // point is captured by value, so it stays in registers during the search
+    int result = leftTangentSearch(poly.size(), [&poly, point](int i)
     {
-        #ifdef DEBUG
-        cnt++;
-        if (cnt >= 3)
-            assert(1<<(cnt - 3) <= poly.size());
-        #endif
-        m = (l + r) / 2;
-        drawTangentState(out, point, poly, l, m, r);
-        if ((poly[l + 1] - point) % (poly[l] - point) == 0)
-        {
-            l++;
-            if (out)
-            {
-                drawText(out, "Так как угол равен нулю, то, чтобы избежать крайних случаев,\\n\
-двигаем левый указатель на 1");
-                endOfSlide(out);
-            }
-            continue;
-        }
-        if ((poly[l + 1] - point) % (poly[l] - point) > 0 && (poly[l] - point) % (poly[l - 1] - point) <= 0)
-        {
-            if (out)
-            {
-                drawText(out, "Поскольку вершина, на которую указывает l, является точкой касания,\\n\
-то выходим из цикла бинпоиска");
-                endOfSlide(out);
-                break;
-            }
-        }
-        if (out)
-        {
-            endOfStep(out);
-            drawTangentState(out, point, poly, l, m, r, l, l + 1);
-            drawText(out, "Смотрим на знак производной");
-            endOfStep(out);
-        }
-        if ((poly[l + 1] - point) % (poly[l] - point) < 0)
-        {
-            if (out)
-            {
-                drawText(out, "Она больше нуля. Теперь посмотрим на знак производной в вершине m");
-                endOfSlide(out);
-                drawTangentState(out, point, poly, l, m, r, m, m + 1);
-            }
-            if ((poly[m + 1] - point) % (poly[m] - point) > 0)
-            {
-                if (out)
-                {
-                    drawText(out, "Так как в вершине m она меньше нуля, то двигаем правую границу");
-                    endOfSlide(out);
-                }
-                r = m;
-            }
-            else
-            {
-                if (out)
-                {
-                    drawText(out, "Она больше нуля, поэтому надо сравнить углы до вершин l и m");
-                    endOfSlide(out);
-                    drawTangentState(out, point, poly, l, m, r, l, m);
-                }
-                if ((poly[l] - point) % (poly[m] - point) < 0)
-                {
-                    if (out)
-                        drawText(out, "Так как вершина l \"выше\" вершина m, то двигаем правый указатель");
-                    r = m;
-                }
-                else
-                {
-                    if (out)
-                        drawText(out, "Так как вершина m \"выше\" вершина l, то двигаем левый указатель");
-                    l = m;
-                }
-                endOfSlide(out);
-            }
-        }
-        else
-        {
-            if (out)
-            {
-                drawText(out, "Она меньше нуля. Теперь посмотрим на знак производной в вершине m");
-                endOfSlide(out);
-                drawTangentState(out, point, poly, l, m, r, m, m + 1);
-            }
-            if ((poly[m + 1] - point) % (poly[m] - point) <= 0)
-            {
-                if (out)
-                {
-                    drawText(out, "Так как в вершине m она больше нуля, то двигаем левую границу");
-                    endOfSlide(out);
-                }
-                l = m;
-            }
-            else
-            {
-                if (out)
-                {
-                    drawText(out, "Она меньше нуля, поэтому надо сравнить углы до вершин l и m");
-                    endOfSlide(out);
-                    drawTangentState(out, point, poly, l, m, r, l, m);
-                }
-                if ((poly[l] - point) % (poly[m] - point) >= 0)
-                {
-                    if (out)
-                        drawText(out, "Так как вершина l \"ниже\" вершина m, то двигаем правый указатель");
-                    r = m;
-                }
-                else
-                {
-                    if (out)
-                        drawText(out, "Так как вершина l \"выше\" вершина m, то двигаем левый указатель");
-                    l = m;
-                }
-                endOfSlide(out);
-            }
-        }
+        return poly[i] - point;
+    },
+    [](const Point &a, const Point &b)
+    {
+        return a % b;
+    },
+    [&](int l, int m, int r, int ang1, int ang2)
+    {
+        drawTangentState(tracer, point, poly, l, m, r, ang1, ang2);
+    }, stats, tracer);
+    if (Tracer::enabled)
+    {
+        drawTangentState(tracer, point, poly, -1, -1, -1);
+        tracer.drawText("Результат");
+        tracer.drawRay(point, poly[result] - point, "blue");
     }
+    return result;
+}
+
+int leftTangent(const Point &point, const Polygon &poly, FILE *out)
+{
     if (out)
-    {                                              
-        drawTangentState(out, point, poly, -1, -1, -1);
-        drawText(out, "Результат");
-    }
-    if ((poly[r] - point) % (poly[r - 1] - point) <= 0)
     {
-        if (out)
-            drawRay(out, point, poly[r] - point, "blue");
-        return r;
+        SlideTracer tracer(out);
+        return leftTangent(point, poly, tracer);
     }
-    else
+    NullTracer tracer;
+    return leftTangent(point, poly, tracer);
+}
+
+template <class Tracer> int rightTangent(const Point &point, const Polygon &poly, Tracer &)
+{
+    StatsScope stats(STATS_RIGHT_TANGENT, poly.size(), 2);
+    if (!Tracer::enabled && poly.hasAngularIndex())
     {
-        if (out)
-            drawRay(out, point, poly[l] - point, "blue");
-        return l;                                   
+        stats.event(STATS_ANGULAR_INDEX);
+        return tangentIndexed(point, poly, -1);
     }
+    return rightTangentSearch(poly.size(), [&poly, point](int i)
+    {
+        return poly[i] - point;
+    },
+    [](const Point &a, const Point &b)
+    {
+        return a % b;
+    }, stats);
 }
 
 int rightTangent(const Point &point, const Polygon &poly, FILE *out)
 {
-    int l, m, r;
-    l = 0, r = poly.size();
-    #ifdef DEBUG
-    int cnt = 0;
-    #endif
-    while (r - l > 1)
+    if (out)
     {
-        #ifdef DEBUG
-        cnt++;
-        if (cnt >= 3)
-            assert(1<<(cnt - 3) <= poly.size());
-        #endif
-        m = (l + r) / 2;
-        if ((poly[l + 1] - point) % (poly[l] - point) == 0)
-        {
-            l++;
-            continue;
-        }
-        if ((poly[l + 1] - point) % (poly[l] - point) < 0 && (poly[l] - point) % (poly[l - 1] - point) >= 0)
-            return l; 
-        if ((poly[l + 1] - point) % (poly[l] - point) < 0)
-        {
-            if ((poly[m + 1] - point) % (poly[m] - point) >= 0)
-                l = m;
-            else
-            {
-                if ((poly[l] - point) % (poly[m] - point) <= 0)
-                    r = m;
-                else
-                    l = m;
-            }
-        }
-        else
-        {
-            if ((poly[m + 1] - point) % (poly[m] - point) < 0)
-                r = m;
-            else
-            {
-                if ((poly[l] - point) % (poly[m] - point) >= 0)
-                    r = m;
-                else
-                    l = m;
-            }
-        }
-    }                 
-    if ((poly[r] - point) % (poly[r - 1] - point) >= 0)
-        return r;
-    return l;                                   
+        SlideTracer tracer(out);
+        return rightTangent(point, poly, tracer);
+    }
+    NullTracer tracer;
+    return rightTangent(point, poly, tracer);
 }
 
 double distance(const Point &point, const Segment &segment)
@@ -743,110 +1417,163 @@ double distance(const Point &point, const Segment &segment)
     return result;
 }
 
+// Same as distanceLinear, but minimizes squared distances to sides, so
+// only one square root is taken
+inline double distanceLinearSoA(const Point &point, const Polygon &poly)
+{
+    const int *x = poly.xs(), *y = poly.ys();
+    int n = poly.size();
+    double result = 1e36;
+    for (int i = 0; i < n; i++)
+    {
+        long long x1 = x[i] - point.x, y1 = y[i] - point.y, x2 = x[i + 1] - point.x, y2 = y[i + 1] - point.y;
+        long long dx = x2 - x1, dy = y2 - y1;
+        double current = (double) min(x1 * x1 + y1 * y1, x2 * x2 + y2 * y2);
+        if (x1 * dx + y1 * dy <= 0 && x2 * dx + y2 * dy >= 0)
+            current = min(current, sqr(double(x1 * y2 - y1 * x2)) / double(dx * dx + dy * dy));
+        result = min(result, current);
+    }
+    return sqrt(result);
+}
+
 double distanceLinear(const Point &point, const Polygon &poly)
 {
+    if (poly.hasSoA())
+        return distanceLinearSoA(point, poly);
     double result = 1e18;
     for (int i = 0; i < poly.size(); i++)
         result = min(result, distance(point, Segment(poly[i], poly[i + 1])));      
     return result;
 }
 
-inline void drawDistanceState(FILE *out, const Point &point, const Polygon &poly, int l, int m, int r, 
+template <class Tracer> inline void drawDistanceState(Tracer &tracer, const Point &point, const Polygon &poly, int l, int m, int r, 
                               int ltangent, int rtangent)
 {
-    drawBinSearchState(out, poly, l, m, r);
-    drawPoint(out, point, "point");
+    tracer.drawBinSearchState(poly, l, m, r);
+    tracer.drawPoint(point, "point");
     if (ltangent != -1)
-        drawRay(out, point, poly[ltangent] - point, "red");
+        tracer.drawRay(point, poly[ltangent] - point, "red");
     if (rtangent != -1)
-        drawRay(out, point, poly[rtangent] - point, "red");
+        tracer.drawRay(point, poly[rtangent] - point, "red");
 }
 
-double distance(const Point &point, const Polygon &poly, FILE *out)
+// Checks that side i is visible from point or point lies on its continuation and
+// distance to point still decreases at the end of the side. On the sides from the
+// left tangent it is true till the nearest side and false after it
+inline bool isBeforeNearest(const Point &point, const Polygon &poly, int i)
 {
-    if (out)
+    Point side = poly[i + 1] - poly[i];
+    return side % (point - poly[i]) <= 0 && (point - poly[i + 1]) * side > 0;
+}
+
+template <class Tracer> double distance(const Point &point, const Polygon &poly, PointDouble *nearest, int *side, Tracer &tracer)
+{
+    if (Tracer::enabled)
     {
-        drawDistanceState(out, point, poly, -1, -1, -1, -1, -1);
-        drawText(out, "Хотим посчитать расстояние от точки до многоугольника");
-        endOfStep(out);
-        drawText(out, "Для этого сначала найдем точки касательных к этому многоугольнику");
-        endOfSlide(out);
+        drawDistanceState(tracer, point, poly, -1, -1, -1, -1, -1);
+        tracer.drawText("Хотим посчитать расстояние от точки до многоугольника");
+        tracer.endOfStep();
+        tracer.drawText("Ближайшая точка лежит на стороне, которую видно из данной точки.\\n\
+Видимые стороны идут подряд, начиная с точки левой касательной");
+        tracer.endOfSlide();
     }
     int ltangent = leftTangent(point, poly);
-    int rtangent = rightTangent(point, poly); 
+    int left = ltangent, right = ltangent + poly.size() - 1;
 
-    if (out)
+    if (Tracer::enabled)
     {
-        drawDistanceState(out, point, poly, -1, -1, -1, ltangent, rtangent);
-        drawText(out, "Теперь хотим найти вершину многоугольника, которая ближе всего к данной точке.\\n\
-Это можно сделать бинпоиском по производной функции расстояния"); 
-        endOfSlide(out);
+        drawDistanceState(tracer, point, poly, left, -1, right, ltangent, -1);
+        tracer.drawText("Вдоль видимых сторон расстояние сначала убывает, а потом возрастает.\\n\
+Найдем бинпоиском первую сторону, которая не видна или в конце которой расстояние возрастает");
+        tracer.endOfSlide();
     }
 
-    int left = ltangent, right = rtangent;
-    
-    if (left >= right)
-        right += poly.size();
-    #ifdef DEBUG
-    int cnt = 0;
-    #endif
-    if (out)
+    StatsScope stats(STATS_DISTANCE, poly.size(), 0);
+    if (isBeforeNearest(point, poly, left))
     {
-        drawDistanceState(out, point, poly, left, -1, right, ltangent, rtangent);
-        drawText(out, "Исходные границы - часть многоугольника от точки левой касательной до\\n\
-точки правой касательной в порядке обхода против часовой стрелки");    
-        endOfStep(out);
-        drawText(out, "Чтобы избежать каких-то крайних случаев, будем делать бинпоиск пока разность между\\n\
-двумя указателями больше трех, остаток разберем руками.");
-        endOfSlide(out);
-    }
-
-    while (right - left > 3)
-    {
-        #ifdef DEBUG
-        cnt++;
-        assert(1<<(cnt - 1) <= poly.size());
-        #endif
-        int left1 = (left + right) / 2, right1 = left1 + 1; 
-        if (left1 == right1)
-            break;
-        if (out)
+        while (right - left > 1)
         {
-            drawDistanceState(out, point, poly, left, left1, right, ltangent, rtangent); 
-            drawSegment(out, point, poly[left1], "blue");
-            drawSegment(out, point, poly[right1], "blue");
-            drawText(out, "Посмотрим на расстояние до вершины m и m+1");
-            endOfStep(out);
-        }
-        if ((point - poly[left1]).len2() > (point - poly[right1]).len2())
-        {
-            if (out)
-                drawText(out, "Так как расстояние до вершины m больше, то двигаем левый указатель");
-            left = left1;
+            stats.iteration();
+            int middle = (left + right) / 2;
+            if (Tracer::enabled)
+            {
+                drawDistanceState(tracer, point, poly, left, middle, right, ltangent, -1);
+                tracer.drawSegment(poly[middle], poly[middle + 1], "blue");
+                tracer.drawText("Посмотрим на сторону m");
+                tracer.endOfStep();
+            }
+            if (isBeforeNearest(point, poly, middle))
+            {
+                if (Tracer::enabled)
+                    tracer.drawText("Сторону видно и расстояние вдоль нее убывает, поэтому двигаем левый указатель");
+                left = middle;
+            }
+            else
+            {
+                if (Tracer::enabled)
+                    tracer.drawText("Сторону не видно или расстояние в ее конце возрастает, поэтому двигаем правый указатель");
+                right = middle;
+            }
+            if (Tracer::enabled)
+                tracer.endOfSlide();
         }
+    }
+    else
+        right = left;
+
+    // Side that is not visible starts at the end of the nearest visible one
+    int pos = right;
+    if ((poly[pos + 1] - poly[pos]) % (point - poly[pos]) > 0)
+        pos--;
+    if (pos < ltangent)
+    {
+        // No side is visible, so point is not outside polygon
+        if (nearest)
+            *nearest = point;
+        if (side)
+            *side = ltangent;
+        return 0;
+    }
+    Point from = poly[pos], dir = poly[pos + 1] - poly[pos];
+    long long projection = (point - from) * dir, len2 = dir.len2();
+    if (nearest)
+    {
+        if (projection <= 0)
+            *nearest = from;
+        else if (projection >= len2)
+            *nearest = poly[pos + 1];
         else
-        {
-            if (out)
-                drawText(out, "Так как расстояние до вершины m меньше, то двигаем правый указатель");
-            right = right1;
-        }
-        if (out)
-            endOfSlide(out);
+            *nearest = PointDouble(from.x + (double) dir.x * (double) projection / (double) len2,
+                                   from.y + (double) dir.y * (double) projection / (double) len2);
     }
+    if (side)
+        *side = pos % poly.size();
 
+    if (Tracer::enabled)
+    {
+        drawDistanceState(tracer, point, poly, -1, pos, -1, -1, -1);
+        tracer.drawSegment(poly[pos], poly[pos + 1], "red");
+        tracer.drawText("Это ближайшая сторона. Ближайшая точка - проекция данной точки на нее\\n\
+или ее конец, если проекция лежит вне стороны");
+    }
+    return distance(point, Segment(poly[pos], poly[pos + 1]));
+}
 
-    int pos = left;
-    for (int i = left + 1; i <= right; i++)
-        if ((point - poly[pos]).len2() > (point - poly[i]).len2())
-            pos = i;
-    
+double distance(const Point &point, const Polygon &poly, PointDouble *nearest, int *side)
+{
+    NullTracer tracer;
+    return distance(point, poly, nearest, side, tracer);
+}
+
+double distance(const Point &point, const Polygon &poly, FILE *out)
+{
     if (out)
-    {   
-        drawDistanceState(out, point, poly, -1, pos, -1, -1, -1);
-        drawText(out, "Самая близкая вершина к данной точке. Теперь надо посмотреть на две стороны многоугольника,\\n\
-соседние с ней, посчитать расстояния до двух отрезков и взять минимум");
-    }        
-    return min(distance(point, Segment(poly[pos], poly[pos + 1])), distance(point, Segment(poly[pos - 1], poly[pos])));
+    {
+        SlideTracer tracer(out);
+        return distance(point, poly, NULL, NULL, tracer);
+    }
+    NullTracer tracer;
+    return distance(point, poly, NULL, NULL, tracer);
 }
 
 PointDouble intersection(const Line &first, const Line &second, bool *ok, FILE *out)
@@ -864,8 +1591,25 @@ PointDouble intersection(const Line &first, const Line &second, bool *ok, FILE *
                        (double(second.a) * first.b - double(second.b) * first.a));
 }
 
+// Finds maximal projection in the first pass and its first occurrence in the
+// second one, so the first loop is a plain reduction
+inline int maximalPointLinearSoA(const Point &dir, const Polygon &poly)
+{
+    const int *x = poly.xs(), *y = poly.ys();
+    int n = poly.size();
+    long long best = (long long) x[0] * dir.x + (long long) y[0] * dir.y;
+    for (int i = 1; i < n; i++)
+        best = max(best, (long long) x[i] * dir.x + (long long) y[i] * dir.y);
+    int result = 0;
+    while ((long long) x[result] * dir.x + (long long) y[result] * dir.y != best)
+        result++;
+    return result;
+}
+
 int maximalPointLinear(const Point &dir, const Polygon &poly)
 {
+    if (poly.hasSoA())
+        return maximalPointLinearSoA(dir, poly);
     int result = 0;
     for (int i = 0; i < poly.size(); i++)
         if (poly[i] * dir > poly[result] * dir)
@@ -875,6 +1619,8 @@ int maximalPointLinear(const Point &dir, const Polygon &poly)
 
 int minimalPointLinear(const Point &dir, const Polygon &poly)
 {
+    if (poly.hasSoA())
+        return maximalPointLinearSoA(Point(-dir.x, -dir.y), poly);
     int result = 0;
     for (int i = 0; i < poly.size(); i++)
         if (poly[i] * dir < poly[result] * dir)
@@ -882,148 +1628,228 @@ int minimalPointLinear(const Point &dir, const Polygon &poly)
     return result;
 }
 
-inline void drawMaximalPointState(FILE *out, const Point &dir, const Polygon &poly, int l, int m, int r)
+template <class Tracer> inline void drawMaximalPointState(Tracer &tracer, const Point &dir, const Polygon &poly, int l, int m, int r)
+{
+    tracer.drawBinSearchState(poly, l, m, r);
+    tracer.drawRay(poly[0], dir, "blue", "direction");        
+}
+
+template <class Tracer> int maximalPoint(const Point &dir, const Polygon &poly, Tracer &tracer)
 {
-    drawBinSearchState(out, poly, l, m, r);
-    drawRay(out, poly[0], dir, "blue", "direction");        
+    StatsScope stats(STATS_MAXIMAL_POINT, poly.size(), 1);
+    if (!Tracer::enabled && poly.hasAngularIndex())
+    {
+        int result = maximalPointIndexed(dir, poly);
+        if (result != -1)
+        {
+            stats.event(STATS_ANGULAR_INDEX);
+            return result;
+        }
+    }
+    if (Tracer::enabled)
+    {
+        drawMaximalPointState(tracer, dir, poly, -1, -1, -1);
+        tracer.drawText("Хотим найти вершину многоугольника, имеющую максимальную проекцию на вектор direction");
+        tracer.endOfSlide();
+        drawMaximalPointState(tracer, dir, poly, 0, -1, poly.size());
+        tracer.drawText("Будем делать бинпоиск, исходные границы покрывают весь многоугольник");
+        tracer.endOfSlide();
+    }
+
+    int l = maximalPointSearch(poly.size(), [&poly](int i)
+    {
+        return poly[i];
+    },
+    [dir](const Point &a, const Point &b)
+    {
+        return (a - b) * dir;
+    },
+    [&](int l, int m, int r)
+    {
+        drawMaximalPointState(tracer, dir, poly, l, m, r);
+    },
+    [&](int i)
+    {
+        tracer.drawAngle(poly[i - 1], poly[i - 1] + dir, poly[i]);
+    }, stats, tracer);
+    if (Tracer::enabled)
+    {
+        drawMaximalPointState(tracer, dir, poly, -1, -1, -1);
+        tracer.drawPoint(poly[l], "result");
+    }
+    return l;
 }
 
 int maximalPoint(const Point &dir, const Polygon &poly, FILE *out)
 {
-    int l = 0, r = poly.size(), m;
     if (out)
     {
-        drawMaximalPointState(out, dir, poly, -1, -1, -1);
-        drawText(out, "Хотим найти вершину многоугольника, имеющую максимальную проекцию на вектор direction");
-        endOfSlide(out);
-        drawMaximalPointState(out, dir, poly, l, -1, r);
-        drawText(out, "Будем делать бинпоиск, исходные границы покрывают весь многоугольник");
-        endOfSlide(out);
+        SlideTracer tracer(out);
+        return maximalPoint(dir, poly, tracer);
     }
-    
-    #ifdef DEBUG
-    int cnt = 0;
-    #endif
-    
-    while (r - l > 1)
+    NullTracer tracer;
+    return maximalPoint(dir, poly, tracer);
+}
+
+template <class Tracer> int minimalPoint(const Point &dir, const Polygon &poly, Tracer &tracer)
+{
+    return maximalPoint(Point(-dir.x, -dir.y), poly, tracer);
+}
+
+int minimalPoint(const Point &dir, const Polygon &poly, FILE *out)
+{
+    if (out)
     {
-        #ifdef DEBUG
-        cnt++;
-        if (cnt >= 2)
-            assert(1<<(cnt - 2) <= poly.size());
-        #endif
-        m = (l + r) / 2;
-        if (out)
-        {
-            drawMaximalPointState(out, dir, poly, l, m, r);
-            endOfStep(out);
-            drawText(out, "Посмотрим на знак скалярного произведения вектора из вершины l-1 в вершину l\\n\
-и вектора направления");
-            drawAngle(out, poly[l - 1], poly[l - 1] + dir, poly[l]);
-            endOfStep(out);
-        }
-        int lDir = sign((poly[l] - poly[l - 1]) * dir);
-        if (lDir == 0)
-        {
-            if ((poly[l + 1] - poly[l]) * dir < 0)
-            {
-                if (out)
-                {
-                    drawText(out, "Поскольку оно равно нулю и при этом скалярное произведение вектора направления и следующей стороны\\n\
-меньше нуля, то эта вершина имеет максимальную проекцию");
-                    endOfSlide(out);
-                }
-                break;
-            }
-            else
-            {
-                if (out)
-                {
-                    drawText(out, "Поскольку оно равно нулю и при этом скалярное произведение вектора направления и следующей стороны\\n\
-больше нуля, то просто двигаем левый указатель на 1 вправо");
-                    endOfSlide(out);
-                }
-                l++;
-                continue;
-            }
-        } 
-        if (lDir > 0)
+        SlideTracer tracer(out);
+        return minimalPoint(dir, poly, tracer);
+    }
+    NullTracer tracer;
+    return minimalPoint(dir, poly, tracer);
+}
+
+bool isInside(const Point &point, const Polygon &poly, int &hint)
+{
+    // Galloping is not counted in iterations, only calls, events and predicates
+    StatsScope stats(STATS_IS_INSIDE, poly.size(), 0);
+    if (!poly.bounds.contains(point))
+    {
+        stats.event(STATS_OUTSIDE_BOUNDS);
+        return 0;
+    }
+    // Vertices that are not to the left of the ray to point go first in the fan
+    int n = poly.size(), h = min(max(hint, 0), n - 1);
+    auto isBefore = [&](int m)
+    {
+        return (point - poly[0]) % (poly[m] - poly[0]) <= 0;
+    };
+    if (isBefore(h))
+        hint = h + gallop([&](int j) { return isBefore(h + j); }, n - h) - 1;
+    else
+        hint = h - gallop([&](int j) { return !isBefore(h - 1 - j); }, h);
+    if (!isBefore(hint))
+        hint--;
+    return isInsideFanTriangle(point, poly, hint);
+}
+
+// Tangent from point to polygon near vertex hint. Sides of polygon from which point is
+// strictly to the right (target == -1) or to the left (target == 1) go in a row,
+// and tangent is the first of them
+inline int tangentNear(const Point &point, const Polygon &poly, int hint, int target)
+{
+    int n = poly.size(), h = (hint % n + n) % n;
+    auto side = [&](int k)
+    {
+        return sign((poly[k + 1] - poly[k]) % (point - poly[k]));
+    };
+    // Vertices between hint and tangent lie on one side of the line through point and poly[h]
+    auto isNear = [&](int k)
+    {
+        return sign((poly[h] - point) % (poly[k] - point)) == -target;
+    };
+    int s = side(h);
+    if (s == 0)
+        return -1;
+    // Binary search that is made instead counts the call itself
+    StatsScope stats(target == -1 ? STATS_LEFT_TANGENT : STATS_RIGHT_TANGENT, n, 0);
+    int result;
+    if (s == target)
+        result = h + 1 - gallop([&](int j) { return side(h - j) == target && (j == 0 || isNear(h - j)); }, n);
+    else
+        result = h - 1 + gallop([&](int j) { return j == 0 || (side(h + j - 1) != target && isNear(h + j)); }, n);
+    return (result % n + n) % n;
+}
+
+int leftTangent(const Point &from, const Polygon &poly, int hint)
+{
+    int result = tangentNear(from, poly, hint, -1);
+    return result == -1 ? leftTangent(from, poly) : result;
+}
+
+int rightTangent(const Point &from, const Polygon &poly, int hint)
+{
+    int result = tangentNear(from, poly, hint, 1);
+    return result == -1 ? rightTangent(from, poly) : result;
+}
+
+int maximalPoint(const Point &dir, const Polygon &poly, int hint)
+{
+    // Projections grow from the minimal vertex to the maximal one and then decrease,
+    // so vertices that are higher than hint go in a row in one direction from it
+    int n = poly.size(), h = (hint % n + n) % n;
+    long long value = poly[h] * dir;
+    auto side = [&](int k)
+    {
+        return (poly[k + 1] - poly[k]) * dir;
+    };
+    if (side(h - 1) == 0 && side(h) == 0)
+        return maximalPoint(dir, poly);
+    // Binary search above counts the call itself
+    StatsScope stats(STATS_MAXIMAL_POINT, n, 0);
+    int result;
+    if (side(h) > 0)
+        result = h + gallop([&](int j) { return side(h + j) > 0 && poly[h + j] * dir >= value; }, n - 1);
+    else if (side(h - 1) < 0)
+        result = h - gallop([&](int j) { return side(h - j - 1) < 0 && poly[h - j] * dir >= value; }, n - 1);
+    else
+        result = h;
+    return (result % n + n) % n;
+}
+
+int minimalPoint(const Point &dir, const Polygon &poly, int hint)
+{
+    return maximalPoint(Point(-dir.x, -dir.y), poly, hint);
+}
+
+// Point where line crosses side from first to second. It is exactly the vertex if
+// line goes through it, so the same crossing is not found twice with rounding errors
+inline PointDouble sideCrossing(const Line &line, const Point &first, const Point &second)
+{
+    if (first * line.normal() + line.c == 0)
+        return first;
+    if (second * line.normal() + line.c == 0)
+        return second;
+    return intersection(line, Line(first, second));
+}
+
+// Same as intersectionLinear, but the value of line equation at each vertex
+// is computed once and sides are read without modulo
+inline SegmentDouble intersectionLinearSoA(const Line &line, const Polygon &poly, bool *ok)
+{
+    const int *x = poly.xs(), *y = poly.ys();
+    int n = poly.size();
+    bool found = 0;
+    SegmentDouble result;
+    long long previous = (long long) line.a * x[0] + (long long) line.b * y[0] + line.c;
+    for (int i = 0; i < n; i++)
+    {
+        long long current = (long long) line.a * x[i + 1] + (long long) line.b * y[i + 1] + line.c;
+        if (previous == 0 && current == 0)
         {
-            if (out)
-            {
-                drawMaximalPointState(out, dir, poly, l, m, r);
-                drawText(out, "Оно больше нуля. Теперь посмотрим на скалярное произведение вектора направления и\\n\
-вектора из точки m-1 в точку m");
-                drawAngle(out, poly[m - 1], poly[m - 1] + dir, poly[m]);
-                endOfStep(out);
-            }
-            if ((poly[m] - poly[m - 1]) * dir < 0)
-            {
-                if (out)
-                    drawText(out, "Так как оно меньше нуля, то двигаем правый указатель");
-                r = m;
-            }
-            else if ((poly[m] - poly[l]) * dir >= 0)
-            {
-                if (out)
-                    drawText(out, "Так как оно больше нуля, и при этом вершина m находится дальше по направлению, то\\n\
-двигаем левый указатель");                
-                l = m;
-            }
-            else
-            {
-                if (out)
-                    drawText(out, "Так как оно больше нуля, и при этом вершина l находится дальше по направлению, то\\n\
-двигаем правый указатель");            
-                r = m;       
-            }            
-            endOfSlide(out);
+            setOk(ok, 1);
+            return SegmentDouble(poly[i], poly[i + 1]);
         }
-        else
+        // Vertex on line is counted with the side that starts at it
+        if (sign(previous) * sign(current) <= 0 && current != 0)
         {
-            if (out)
-            {
-                drawMaximalPointState(out, dir, poly, l, m, r);
-                drawText(out, "Оно меньше нуля. Теперь посмотрим на скалярное произведение вектора направления и\\n\
-вектора из точки m-1 в точку m");
-                drawAngle(out, poly[m - 1], poly[m - 1] + dir, poly[m]);
-                endOfStep(out);
-            }
-            if ((poly[m] - poly[m - 1]) * dir >= 0)
+            PointDouble tmp = sideCrossing(line, poly[i], poly[i + 1]);
+            if (!found)
             {
-                if (out)
-                    drawText(out, "Так как оно больше нуля, то двигаем левый указатель");
-                l = m;
-            }
-            else if ((poly[m] - poly[l]) * dir <= 0)
-            {
-                if (out)
-                    drawText(out, "Так как оно меньше нуля, и при этом вершина l находится дальше по направлению, то\\n\
-двигаем левый указатель");                
-                l = m;
-            }
-            else
-            {
-                if (out)
-                    drawText(out, "Так как оно больше нуля, и при этом вершина m находится дальше по направлению, то\\n\
-двигаем левый указатель");                
-                r = m;                                  
+                result.first = result.second = tmp;
+                found = 1;
             }
-            endOfSlide(out);
+            else if (tmp != result.first)
+                result.second = tmp;
         }
-    }    
-    drawMaximalPointState(out, dir, poly, -1, -1,- 1);
-    drawPoint(out, poly[l], "result");
-    return l;
-}
-
-int minimalPoint(const Point &dir, const Polygon &poly, FILE *out)
-{
-    return maximalPoint(Point(-dir.x, -dir.y), poly);
+        previous = current;
+    }
+    setOk(ok, found);
+    return result;
 }
 
 SegmentDouble intersectionLinear(const Line &line, const Polygon &poly, bool *ok)
 {
+    if (poly.hasSoA())
+        return intersectionLinearSoA(line, poly, ok);
     bool found = 0;
     SegmentDouble result; 
     for (int i = 0; i < poly.size(); i++)
@@ -1033,16 +1859,17 @@ SegmentDouble intersectionLinear(const Line &line, const Polygon &poly, bool *ok
             setOk(ok, 1);
             return SegmentDouble(poly[i], poly[i + 1]);
         }
-        if (isIntersection(line, Segment(poly[i], poly[i + 1])))
+        // Vertex on line is counted with the side that starts at it
+        if (isIntersection(line, Segment(poly[i], poly[i + 1])) && line.normal() * poly[i + 1] + line.c != 0)
         {
             if (!found)            
             {
-                result.first = result.second = intersection(line, Line(poly[i], poly[i + 1]));
+                result.first = result.second = sideCrossing(line, poly[i], poly[i + 1]);
                 found = 1;
             }
             else
             {
-                PointDouble tmp = intersection(line, Line(poly[i], poly[i + 1]));
+                PointDouble tmp = sideCrossing(line, poly[i], poly[i + 1]);
                 if (tmp != result.first)
                     result.second = tmp;
             }
@@ -1052,20 +1879,28 @@ SegmentDouble intersectionLinear(const Line &line, const Polygon &poly, bool *ok
     return result;
 }
 
-inline void drawIntersectionState(FILE *out, const Line &line, const Polygon &poly, int l, int m, int r, 
+template <class Tracer> inline void drawIntersectionState(Tracer &tracer, const Line &line, const Polygon &poly, int l, int m, int r, 
         const PointDouble *points, int cnt)
 {
-    drawBinSearchState(out, poly, l, m, r);
-    drawLine(out, line, "red");
+    tracer.drawBinSearchState(poly, l, m, r);
+    tracer.drawLine(line, "red");
     if (cnt >= 1)
-        printf("draw point %f %f name=first\n", points[0].x, points[0].y);
+        tracer.drawPoint(points[0], "first");
     if (cnt >= 2)
-        printf("draw point %f %f name=second\n", points[1].x, points[1].y);
-    puts("wait");
+        tracer.drawPoint(points[1], "second");
+    tracer.endOfStep();
 }
 
-SegmentDouble intersection(const Line &line, const Polygon &poly, bool *ok, FILE *out)
+template <class Tracer> SegmentDouble intersection(const Line &line, const Polygon &poly, bool *ok, Tracer &tracer)
 {
+    // Two binary searches over arcs of at most size() sides
+    StatsScope stats(STATS_INTERSECTION, 1ll * poly.size() * poly.size(), 1);
+    if (!Tracer::enabled && !poly.bounds.crosses(line))
+    {
+        stats.event(STATS_OUTSIDE_BOUNDS);
+        setOk(ok, 0);
+        return SegmentDouble(PointDouble(0, 0), PointDouble(0, 0));
+    }
     int left = minimalPoint(line.normal(), poly), right = maximalPoint(line.normal(), poly);
     int cnt = 0;
     PointDouble points[2];
@@ -1074,6 +1909,7 @@ SegmentDouble intersection(const Line &line, const Polygon &poly, bool *ok, FILE
     {
         if (poly[left] * line.normal() + line.c == 0)
         {         
+            stats.event(STATS_EARLY_EXIT);
             setOk(ok, 1);
             if (poly[left - 1] * line.normal() + line.c == 0)
                 return SegmentDouble(poly[left - 1], poly[left]);
@@ -1085,34 +1921,31 @@ SegmentDouble intersection(const Line &line, const Polygon &poly, bool *ok, FILE
         swap(left, right);
     }      
 
-    #ifdef DEBUG
-    int counter = 0;
-    #endif
     for(int i = 0; i < 2; i++)
     {
-        #ifdef DEBUG
-        counter++;
-        assert(1<<((counter - 1) / 2) <= poly.size());
-        #endif
         int l = left, r = right, m;
         if (l >= r)
             r += poly.size();
-        drawIntersectionState(out, line, poly, l, -1, r, points, cnt); 
+        if (Tracer::enabled)
+            drawIntersectionState(tracer, line, poly, l, -1, r, points, cnt);
         int signR = sign(line.normal() * poly[r] + line.c);
         while (r - l > 1)
         {
+            stats.iteration();
             m = (l + r) / 2;
-            drawIntersectionState(out, line, poly, l, m, r, points, cnt); 
+            if (Tracer::enabled)
+                drawIntersectionState(tracer, line, poly, l, m, r, points, cnt);
             if (signR == sign(line.normal() * poly[m] + line.c))
                 r = m;
             else
                 l = m;    
         }
         if (isIntersection(line, Segment(poly[l], poly[l + 1])))
-            points[cnt++] = intersection(line, Line(poly[l], poly[l + 1]));
+            points[cnt++] = sideCrossing(line, poly[l], poly[l + 1]);
         swap(left, right);
     }   
-    drawIntersectionState(out, line, poly, -1, -1, -1, points, cnt);
+    if (Tracer::enabled)
+        drawIntersectionState(tracer, line, poly, -1, -1, -1, points, cnt);
 
     if (cnt == 0)
     {
@@ -1125,3 +1958,503 @@ SegmentDouble intersection(const Line &line, const Polygon &poly, bool *ok, FILE
         return SegmentDouble(points[0], points[1]);                        
     }
 }
+
+SegmentDouble intersection(const Line &line, const Polygon &poly, bool *ok, FILE *out)
+{
+    if (out)
+    {
+        SlideTracer tracer(out);
+        return intersection(line, poly, ok, tracer);
+    }
+    NullTracer tracer;
+    return intersection(line, poly, ok, tracer);
+}
+
+// Index of side of polygon that has the smallest angle by compareByAngle, so sides starting
+// from it are sorted by angle. For reflected polygon it is the side that goes to the right
+// from the lowest vertex, with sides taken in the opposite direction
+inline int firstSideByAngle(const Polygon &poly, bool reflected = 0)
+{
+    if (!reflected)
+        return poly.upmost;
+    int result = poly.downmost;
+    for (int i = 1; i < poly.size() && poly[result - 1].y == poly[result].y; i++)
+        result--;
+    return (result + poly.size()) % poly.size();
+}
+
+// Point where lines through sides cross, sides should not be parallel
+inline PointDouble crossing(const Segment &first, const Segment &second)
+{
+    Point dir = first.second - first.first;
+    long double t = (long double) ((second.first - first.first) % (second.second - second.first)) /
+                    (long double) (dir % (second.second - second.first));
+    return PointDouble((double) (first.first.x + dir.x * t), (double) (first.first.y + dir.y * t));
+}
+
+// Checks that point lies strictly to the right of the line through side, with relative error eps
+inline bool isOutside(const PointDouble &point, const Segment &side)
+{
+    Point dir = side.second - side.first;
+    long double dx = (long double) point.x - side.first.x, dy = (long double) point.y - side.first.y;
+    return dir.x * dy - dir.y * dx < -eps * dir.len() * (1 + fabs(point.x) + fabs(point.y));
+}
+
+vector <PointDouble> intersection(const Polygon &first, const Polygon &second)
+{
+    // Intersection of half-planes to the left of sides. Sides of both polygons are
+    // already sorted by angle, so they are merged in linear time
+    vector <Segment> sides;
+    int i = firstSideByAngle(first), j = firstSideByAngle(second);
+    for (int a = 0, b = 0; a < first.size() || b < second.size(); )
+    {
+        Segment side1(first[i + a], first[i + a + 1]), side2(second[j + b], second[j + b + 1]);
+        if (b == second.size() || (a < first.size() &&
+            !compareByAngle(side2.second - side2.first, side1.second - side1.first)))
+        {
+            sides.push_back(side1);
+            a++;
+        }
+        else
+        {
+            sides.push_back(side2);
+            b++;
+        }
+    }
+    // Deque of sides whose half-planes bound the intersection
+    vector <Segment> hull(sides.size());
+    int head = 0, tail = 0;
+    for (auto &side : sides)
+    {
+        while (tail - head >= 2 && isOutside(crossing(hull[tail - 1], hull[tail - 2]), side))
+            tail--;
+        while (tail - head >= 2 && isOutside(crossing(hull[head], hull[head + 1]), side))
+            head++;
+        Point dir = side.second - side.first;
+        if (tail - head >= 1 && (hull[tail - 1].second - hull[tail - 1].first) % dir == 0)
+        {
+            // Half-planes of opposite sides do not intersect, of the parallel ones the inner one is kept
+            if ((hull[tail - 1].second - hull[tail - 1].first) * dir < 0)
+                return vector <PointDouble> ();
+            if (dir % (hull[tail - 1].first - side.first) >= 0)
+                continue;
+            tail--;
+        }
+        hull[tail++] = side;
+    }
+    while (tail - head >= 3 && isOutside(crossing(hull[tail - 1], hull[tail - 2]), hull[head]))
+        tail--;
+    while (tail - head >= 3 && isOutside(crossing(hull[head], hull[head + 1]), hull[tail - 1]))
+        head++;
+    vector <PointDouble> result;
+    if (tail - head < 3)
+        return result;
+    for (int k = head; k < tail; k++)
+    {
+        PointDouble point = crossing(hull[k], hull[k + 1 < tail ? k + 1 : head]);
+        if (result.empty() || (result.back() != point && result[0] != point))
+            result.push_back(point);
+    }
+    // If intersection is empty then crossings of sides left in the deque lie outside
+    // some other side, otherwise all of them lie inside all sides
+    for (auto &side : sides)
+        if (isOutside(result[0], side))
+            return vector <PointDouble> ();
+    return result;
+}
+
+// Point with coordinates that do not fit in int, such as vertices of Minkowski sums
+struct WidePoint
+{
+    long long x, y;
+
+    WidePoint(long long _x, long long _y) : x(_x), y(_y) {}
+    WidePoint(const Point &point) : x(point.x), y(point.y) {}
+    WidePoint operator + (const WidePoint &rhs) const { return WidePoint(x + rhs.x, y + rhs.y); }
+    WidePoint operator - (const WidePoint &rhs) const { return WidePoint(x - rhs.x, y - rhs.y); }
+    bool operator == (const WidePoint &rhs) const { return x == rhs.x && y == rhs.y; }
+};
+
+// Products of coordinates up to 2^33 by absolute value do not fit in long long,
+// so they are multiplied in 128 bits if compiler has them
+#ifdef __SIZEOF_INT128__
+typedef __int128 WideProduct;
+#else
+typedef long double WideProduct;
+#endif
+
+inline WideProduct cross(const WidePoint &a, const WidePoint &b)
+{
+    return (WideProduct) a.x * b.y - (WideProduct) a.y * b.x;
+}
+
+// Signs of vector and scalar multiplication of two vectors
+inline int crossSign(const WidePoint &a, const WidePoint &b)
+{
+    WideProduct result = cross(a, b);
+    return (result > 0) - (result < 0);
+}
+
+inline int dotSign(const WidePoint &a, const WidePoint &b)
+{
+    WideProduct result = (WideProduct) a.x * b.x + (WideProduct) a.y * b.y;
+    return (result > 0) - (result < 0);
+}
+
+// Checks that point lies in the Minkowski difference D of first and second, i.e. it equals a - b
+// for some a from first and b from second.
+// Boundary of D goes through w_i = first[i] - second[j_i], where second[j_i] is minimal along
+// the normal of side i - 1 of first, and from w_i to w_{i + 1} through first[i] - second[j]
+// for j from j_i to j_{i + 1}. So point is found in the fan of boundary of D from w_0
+// by binary search over w_i and then over j
+inline bool isInsideDifference(const Polygon &first, const Polygon &second, const WidePoint &point)
+{
+    int n = first.size(), m = second.size();
+    auto secondIndex = [&](int i)
+    {
+        Point side = first[i] - first[i - 1];
+        return minimalPoint(Point(side.y, -side.x), second);
+    };
+    auto chainSize = [&](int i, int j)
+    {
+        return ((secondIndex(i + 1 < n ? i + 1 : 0) - j) % m + m) % m;
+    };
+    auto vertex = [&](int i, int j)
+    {
+        return WidePoint(first[i]) - WidePoint(second[j]);
+    };
+    int j0 = secondIndex(0);
+    WidePoint w0 = vertex(0, j0);
+    if (w0 == point)
+        return 1;
+    // Sign of position of point relative to the ray from w0 to vertex, 1 if it is to the left
+    auto side = [&](const WidePoint &vertex)
+    {
+        return crossSign(vertex - w0, point - w0);
+    };
+    auto isLeft = [&](const WidePoint &vertex)
+    {
+        return side(vertex) >= 0;
+    };
+
+    WidePoint next = chainSize(0, j0) ? vertex(0, j0 + 1) : vertex(1, secondIndex(1));
+    WidePoint last = vertex(n - 1, j0);
+    if (!isLeft(next) || side(last) > 0)
+        return 0;
+    if (side(last) == 0)
+    {
+        // Point lies on the line through the side of D that comes to w0. Besides last,
+        // one vertex before it and one vertex after w0 may lie on this side
+        WidePoint before = chainSize(n - 1, secondIndex(n - 1)) ? vertex(n - 1, j0 - 1) : vertex(n - 2, j0);
+        WidePoint from = side(before) == 0 ? before : last, to = side(next) == 0 ? next : w0;
+        return min(from.x, to.x) <= point.x && max(from.x, to.x) >= point.x &&
+               min(from.y, to.y) <= point.y && max(from.y, to.y) >= point.y;
+    }
+
+    int left = 0, right = n;
+    while (right - left > 1)
+    {
+        int middle = (left + right) / 2;
+        if (isLeft(vertex(middle, secondIndex(middle))))
+            left = middle;
+        else
+            right = middle;
+    }
+    int j = secondIndex(left), size = chainSize(left, j);
+    int from = left == 0 ? 1 : 0, to = size + 1;
+    while (to - from > 1)
+    {
+        int middle = (from + to) / 2;
+        if (isLeft(vertex(left, j + middle)))
+            from = middle;
+        else
+            to = middle;
+    }
+    // Point is to the right of the ray to last, so the following vertex exists
+    WidePoint current = vertex(left, j + from);
+    WidePoint following = from < size ? vertex(left, j + from + 1) : vertex(left + 1, j + from);
+    return crossSign(following - current, point - current) >= 0;
+}
+
+bool isIntersection(const Polygon &first, const Polygon &second)
+{
+    // Polygons intersect iff origin lies in the Minkowski difference of first and second
+    return first.bounds.overlaps(second.bounds) && isInsideDifference(first, second, WidePoint(0, 0));
+}
+
+bool isCollision(const Polygon &first, const Point &shift, const Polygon &second)
+{
+    // a + shift = b for some a from first and b from second iff shift lies in second - first
+    return first.bounds.overlaps(second.bounds, shift) && isInsideDifference(second, first, WidePoint(shift));
+}
+
+Polygon minkowskiSum(const Polygon &first, const Polygon &second)
+{
+    // Sides of both polygons are already sorted by angle, so they are merged in linear time.
+    // Parallel sides give one side of the sum
+    int n = first.size(), m = second.size();
+    int i = firstSideByAngle(first), j = firstSideByAngle(second);
+    vector <Point> points(1, first[i] + second[j]);
+    for (int a = 0, b = 0; a < n || b < m; )
+    {
+        Point side1 = first[i + a + 1] - first[i + a], side2 = second[j + b + 1] - second[j + b], side;
+        if (b == m || (a < n && !compareByAngle(side2, side1)))
+            side = side1, a++;
+        else
+            side = side2, b++;
+        size_t size = points.size();
+        if (size >= 2 && (points[size - 1] - points[size - 2]) % side == 0 && (points[size - 1] - points[size - 2]) * side > 0)
+            points.back() += side;
+        else
+            points.push_back(points.back() + side);
+    }
+    // Last vertex is the first one again
+    points.pop_back();
+    return Polygon(points);
+}
+
+// Boundary of the Minkowski difference D of first and second that is not built explicitly.
+// Side k of D is the k-th one among sides of first and reflected second merged by angle,
+// so vertex k is found by binary search over the number of sides of first among them.
+// Parallel sides of first and second give collinear vertices of D
+struct DifferenceView
+{
+    DifferenceView(const Polygon &_first, const Polygon &_second) : first(_first), second(_second),
+        firstStart(firstSideByAngle(_first)), secondStart(firstSideByAngle(_second, 1)) {}
+
+    int size() const
+    {
+        return first.size() + second.size();
+    }
+
+    // Side a of first and side b of reflected second in the order of merging
+    Point firstSide(int a) const
+    {
+        return first[firstStart + a + 1] - first[firstStart + a];
+    }
+    Point secondSide(int b) const
+    {
+        return second[secondStart + b] - second[secondStart + b + 1];
+    }
+
+    // Number of sides of first among the first k sides of D, 0 <= k < size()
+    int firstSides(int k) const
+    {
+        int low = max(0, k - second.size()), high = min(k, first.size());
+        while (low < high)
+        {
+            int middle = (low + high + 1) / 2;
+            if (!compareByAngle(secondSide(k - middle), firstSide(middle - 1)))
+                low = middle;
+            else
+                high = middle - 1;
+        }
+        return low;
+    }
+
+    // Vertex k of D, k is taken modulo size()
+    WidePoint operator [] (int k) const
+    {
+        k = (k % size() + size()) % size();
+        int a = firstSides(k);
+        return WidePoint(first[firstStart + a]) - WidePoint(second[secondStart + k - a]);
+    }
+
+    // Number of sides of first or of reflected second that go before direction by angle
+    int sidesBefore(const Point &direction, bool ofFirst) const
+    {
+        int low = 0, high = ofFirst ? first.size() : second.size();
+        while (low < high)
+        {
+            int middle = (low + high) / 2;
+            if (compareByAngle(ofFirst ? firstSide(middle) : secondSide(middle), direction))
+                low = middle + 1;
+            else
+                high = middle;
+        }
+        return low;
+    }
+
+    // Index of vertex of D that is maximal along dir. Boundary of D goes in this
+    // direction up to the vertex where its sides turn past the tangent
+    int extreme(const Point &dir) const
+    {
+        Point tangent(-dir.y, dir.x);
+        return sidesBefore(tangent, 1) + sidesBefore(tangent, 0);
+    }
+
+    const Polygon &first, &second;
+    int firstStart, secondStart;
+};
+
+double penetrationDepth(const Polygon &first, const Point &shift, const Polygon &second, const Point &dir)
+{
+    // first moved by shift + t * dir intersects second iff shift + t * dir lies in the Minkowski
+    // difference D of second and first. Line through shift along dir crosses boundary of D
+    // once on each chain between extreme vertices of D along the normal of dir, these
+    // crossings are found by binary search over vertices of D
+    DifferenceView view(second, first);
+    WidePoint origin(shift), normal(-dir.y, dir.x);
+    auto height = [&](int k)
+    {
+        WidePoint point = view[k] - origin;
+        return point.x * normal.x + point.y * normal.y;
+    };
+    int top = view.extreme(Point(-dir.y, dir.x)), bottom = view.extreme(Point(dir.y, -dir.x));
+    if (height(top) <= 0 || height(bottom) >= 0)
+        return 0;
+    // Value of t where line crosses side k of D
+    auto crossing = [&](int k)
+    {
+        WidePoint from = view[k] - origin, side = view[k + 1] - view[k];
+        return (long double) cross(from, side) / (long double) cross(WidePoint(dir), side);
+    };
+    int from = bottom, to = top < bottom ? top + view.size() : top;
+    while (to - from > 1)
+    {
+        int middle = (from + to) / 2;
+        if (height(middle) < 0)
+            from = middle;
+        else
+            to = middle;
+    }
+    long double enter = crossing(from);
+    from = top, to = bottom < top ? bottom + view.size() : bottom;
+    while (to - from > 1)
+    {
+        int middle = (from + to) / 2;
+        if (height(middle) > 0)
+            from = middle;
+        else
+            to = middle;
+    }
+    long double leave = crossing(from);
+    if (enter > leave)
+        swap(enter, leave);
+    if (enter >= 0 || leave <= 0)
+        return 0;
+    return (double) (leave * dir.len());
+}
+
+// Left tangent from origin to D that does not contain it. Every vertex of D takes
+// O(log min(n, m)), so it is found in O(log n log m)
+inline int leftTangent(const DifferenceView &view)
+{
+    StatsScope stats(STATS_LEFT_TANGENT, view.size(), 2);
+    NullTracer tracer;
+    return leftTangentSearch(view.size(), [&view](int i)
+    {
+        return view[i];
+    },
+    [](const WidePoint &a, const WidePoint &b)
+    {
+        return crossSign(a, b);
+    },
+    [](int, int, int, int, int) {}, stats, tracer);
+}
+
+// Side of D that is nearest to origin that lies outside D, the same binary search
+// as in distance for point and polygon
+inline int nearestSide(const DifferenceView &view)
+{
+    WidePoint origin(0, 0);
+    auto isBeforeNearest = [&](int k)
+    {
+        WidePoint from = view[k], to = view[k + 1];
+        return crossSign(to - from, origin - from) <= 0 && dotSign(origin - to, to - from) > 0;
+    };
+    int left = leftTangent(view), right = left + view.size() - 1;
+    if (isBeforeNearest(left))
+    {
+        while (right - left > 1)
+        {
+            int middle = (left + right) / 2;
+            if (isBeforeNearest(middle))
+                left = middle;
+            else
+                right = middle;
+        }
+    }
+    else
+        right = left;
+    // Side that is not visible starts at the end of the nearest visible one
+    if (crossSign(view[right + 1] - view[right], origin - view[right]) > 0)
+        right--;
+    return (right % view.size() + view.size()) % view.size();
+}
+
+double distance(const Polygon &first, const Polygon &second, PointDouble *firstNearest, PointDouble *secondNearest)
+{
+    // Distance between polygons is the distance from origin to their Minkowski difference D
+    if (isIntersection(first, second))
+        return 0;
+    DifferenceView view(first, second);
+    int k = nearestSide(view), a = view.firstSides(k);
+    WidePoint from = view[k], side = view[k + 1] - from;
+    // Nearest point of side is from + side * t
+    long double projection = -(long double) ((WideProduct) from.x * side.x + (WideProduct) from.y * side.y);
+    long double len2 = (long double) side.x * side.x + (long double) side.y * side.y, t = 0, result;
+    if (projection >= len2)
+    {
+        t = 1;
+        result = sqrtl((long double) (from.x + side.x) * (from.x + side.x) + (long double) (from.y + side.y) * (from.y + side.y));
+    }
+    else if (projection > 0)
+    {
+        t = projection / len2;
+        result = fabsl((long double) cross(side, from)) / sqrtl(len2);
+    }
+    else
+        result = sqrtl((long double) from.x * from.x + (long double) from.y * from.y);
+
+    // Side k of D is a side of first or of reflected second that goes from first[i] - second[j]
+    Point p = first[view.firstStart + a], q = second[view.secondStart + k - a];
+    bool isFirstSide = k + 1 < view.size() ? view.firstSides(k + 1) > a : a < first.size();
+    Point dir = isFirstSide ? first[view.firstStart + a + 1] - p : second[view.secondStart + k - a + 1] - q;
+    PointDouble moved((double) (dir.x * t), (double) (dir.y * t));
+    if (firstNearest)
+        *firstNearest = isFirstSide ? PointDouble(p.x + moved.x, p.y + moved.y) : PointDouble(p);
+    if (secondNearest)
+        *secondNearest = isFirstSide ? PointDouble(q) : PointDouble(q.x + moved.x, q.y + moved.y);
+    return (double) result;
+}
+
+Line separatingLine(const Polygon &first, const Polygon &second, bool *ok)
+{
+    // Polygons do not intersect iff some side of D has origin strictly outside, then its
+    // normal separates projections of polygons. Nearest side of D is such side unless
+    // origin lies on its continuation, then one of the next sides on the line is not
+    bool result = !isIntersection(first, second);
+    setOk(ok, result);
+    if (!result)
+        return Line(0, 0, 0);
+    DifferenceView view(first, second);
+    int k = nearestSide(view);
+    auto isVisible = [&](int k)
+    {
+        return crossSign(view[k + 1] - view[k], WidePoint(0, 0) - view[k]) < 0;
+    };
+    for (int step = 1; !isVisible(k); step++)
+        k += step % 2 ? step : -step;
+    // Sides of D are sides of polygons, so they fit in int
+    WidePoint side = view[k + 1] - view[k];
+    Point normal((int) side.y, (int) -side.x);
+    long long firstMax = first[maximalPoint(normal, first)] * normal;
+    long long secondMin = second[minimalPoint(normal, second)] * normal;
+    return Line(normal.x, normal.y, -(firstMax + (secondMin - firstMax + 1) / 2));
+}
+
+template bool isInside(const Point&, const Polygon&, NullTracer&);
+template bool isInside(const Point&, const Polygon&, SlideTracer&);
+template int leftTangent(const Point&, const Polygon&, NullTracer&);
+template int leftTangent(const Point&, const Polygon&, SlideTracer&);
+template int rightTangent(const Point&, const Polygon&, NullTracer&);
+template int rightTangent(const Point&, const Polygon&, SlideTracer&);
+template double distance(const Point&, const Polygon&, PointDouble*, int*, NullTracer&);
+template double distance(const Point&, const Polygon&, PointDouble*, int*, SlideTracer&);
+template int maximalPoint(const Point&, const Polygon&, NullTracer&);
+template int maximalPoint(const Point&, const Polygon&, SlideTracer&);
+template int minimalPoint(const Point&, const Polygon&, NullTracer&);
+template int minimalPoint(const Point&, const Polygon&, SlideTracer&);
+template SegmentDouble intersection(const Line&, const Polygon&, bool*, NullTracer&);
+template SegmentDouble intersection(const Line&, const Polygon&, bool*, SlideTracer&);
@@ -7,9 +7,25 @@
 #include <cstdlib>
 #include <vector>
 #include <cassert>
+#include <new>
+#include "stats.h"
+
+// Point and Line arithmetic and orientation predicates below are defined in this
+// header, so they are inlined in every translation unit. They are constexpr, so
+// polygons known at compile time can be checked with static_assert, except when
+// evaluations of % and * are counted (see stats.h)
+#ifdef GEOMETRY_STATS
+#define GEOMETRY_CONSTEXPR inline
+#else
+#define GEOMETRY_CONSTEXPR constexpr
+#endif
+
+constexpr int sign(long long a) noexcept
+{
+    return a == 0 ? 0 : (a > 0 ? 1 : -1);
+}
 
-int sign(long long a);
-template <class T> T sqr(const T &a)
+template <class T> constexpr T sqr(const T &a)
 {
     return a * a;
 }
@@ -24,32 +40,99 @@ struct Point
 {   
     int x, y;
 
-    Point();
-    Point(int x, int y);
-    Point operator + (const Point &rhs) const;
-    Point operator - (const Point &rhs) const;
+    constexpr Point() noexcept : x(0), y(0) {}
+    constexpr Point(int _x, int _y) noexcept : x(_x), y(_y) {}
+    constexpr Point operator + (const Point &rhs) const noexcept
+    {
+        return Point(x + rhs.x, y + rhs.y);
+    }
+    constexpr Point operator - (const Point &rhs) const noexcept
+    {
+        return Point(x - rhs.x, y - rhs.y);
+    }
     // Scalar multiplication of two vectors
-    long long operator * (const Point &rhs) const;
+    GEOMETRY_CONSTEXPR long long operator * (const Point &rhs) const noexcept
+    {
+        #ifdef GEOMETRY_STATS
+        countPredicate();
+        #endif
+        return 1ll * x * rhs.x + 1ll * y * rhs.y;
+    }
     // Vector multiplication of two vectors
-    long long operator % (const Point &rhs) const;
+    GEOMETRY_CONSTEXPR long long operator % (const Point &rhs) const noexcept
+    {
+        #ifdef GEOMETRY_STATS
+        countPredicate();
+        #endif
+        return 1ll * x * rhs.y - 1ll * y * rhs.x;
+    }
     // Multiplication of vector by number
-    Point operator * (int a) const;
-
-    Point& operator += (const Point &rhs);
-    Point& operator -= (const Point &rhs);
-    Point& operator *= (int a);
+    constexpr Point operator * (int a) const noexcept
+    {
+        return Point(x * a, y * a);
+    }
+
+    Point& operator += (const Point &rhs) noexcept
+    {
+        x += rhs.x;
+        y += rhs.y;
+        return *this;
+    }
+    Point& operator -= (const Point &rhs) noexcept
+    {
+        x -= rhs.x;
+        y -= rhs.y;
+        return *this;
+    }
+    Point& operator *= (int a) noexcept
+    {
+        x *= a;
+        y *= a;
+        return *this;
+    }
     
     operator PointDouble() const;
 
-    bool operator == (const Point &rhs) const;
-    bool operator != (const Point &rhs) const;
+    constexpr bool operator == (const Point &rhs) const noexcept
+    {
+        return x == rhs.x && y == rhs.y;
+    }
+    constexpr bool operator != (const Point &rhs) const noexcept
+    {
+        return x != rhs.x || y != rhs.y;
+    }
 
     double len() const;
     // Squared length of vector    
-    long long len2() const;
-
+    constexpr long long len2() const noexcept
+    {
+        return 1ll * x * x + 1ll * y * y;
+    }
 };
 
+// 1 if c is to the left of vector from a to b, -1 if it is to the right and 0 if
+// points are collinear
+GEOMETRY_CONSTEXPR int orientation(const Point &a, const Point &b, const Point &c) noexcept
+{
+    return sign((b - a) % (c - a));
+}
+
+// Checks that vertices j, j + 1, ..., count - 1 except i and i + 1 are strictly to
+// the left of side from points[i] to points[i + 1]
+GEOMETRY_CONSTEXPR bool isLeftOfSide(const Point *points, int count, int i, int j) noexcept
+{
+    return j == count || ((j == i || j == (i + 1) % count || orientation(points[i], points[(i + 1) % count], points[j]) > 0) &&
+                          isLeftOfSide(points, count, i, j + 1));
+}
+
+// Checks that count points are vertices of strictly convex polygon in counter-clockwise
+// order, that is every vertex is to the left of every side it does not belong to.
+// Takes O(count^2) and can be used in static_assert for polygons of up to a few hundred vertices
+GEOMETRY_CONSTEXPR bool isStrictlyConvex(const Point *points, int count, int i = 0) noexcept
+{
+    return count >= 3 && (i == count || (isLeftOfSide(points, count, i, 0) && isStrictlyConvex(points, count, i + 1)));
+}
+
 struct PointDouble
 {
     double x, y;
@@ -61,29 +144,182 @@ struct PointDouble
     bool operator != (const PointDouble &other) const;
 };
 
+// Lookup table of angle buckets. Bucket b stores the first element of
+// angle-sorted sequence that has angle not less than the start of the bucket,
+// so a direction is mapped to a small range of elements in O(1).
+struct AngularIndex
+{
+    AngularIndex();
+    // angles are pseudo angles counted from origin. They should be sorted and lie in [0, span)
+    AngularIndex(const std::vector <double> &angles, double origin, double span, int buckets);
+    // Sets from and to so that elements before from have smaller angle than the given
+    // one and elements starting from to have greater angle
+    void range(double angle, int &from, int &to) const;
+
+    std::vector <int> first;
+    double origin, span;
+};
+
+// Allocator for std::vector that aligns storage by 32 bytes, so
+// whole AVX registers can be loaded from it
+template <class T> struct AlignedAllocator
+{
+    typedef T value_type;
+    AlignedAllocator() {}
+    template <class U> AlignedAllocator(const AlignedAllocator <U> &) {}
+
+    T* allocate(size_t n)
+    {
+        char *raw = (char*) malloc(n * sizeof(T) + 32 + sizeof(void*));
+        if (!raw)
+            throw std::bad_alloc();
+        char *aligned = raw + sizeof(void*) + 32 - ((size_t) (raw + sizeof(void*)) & 31);
+        ((void**) aligned)[-1] = raw;
+        return (T*) aligned;
+    }
+
+    void deallocate(T *p, size_t)
+    {
+        free(((void**) p)[-1]);
+    }
+
+    template <class U> bool operator == (const AlignedAllocator <U> &) const { return 1; }
+    template <class U> bool operator != (const AlignedAllocator <U> &) const { return 0; }
+};
+
+struct Line
+{
+    // Constructs line a * x + b * y + c = 0
+    constexpr Line(int _a, int _b, long long _c) noexcept : a(_a), b(_b), c(_c) {}
+    // Constructs line through given two points
+    constexpr Line(const Point &first, const Point &second) noexcept :
+        a(second.y - first.y), b(first.x - second.x), c(1ll * first.y * second.x - 1ll * first.x * second.y) {}
+    constexpr Point normal() const noexcept
+    {
+        return Point(a, b);
+    }
+    constexpr Point direction() const noexcept
+    {
+        return Point(-b, a);
+    }
+    // Sign of a * x + b * y + c at point, that is the side of line where it lies
+    GEOMETRY_CONSTEXPR int side(const Point &point) const noexcept
+    {
+        return sign(normal() * point + c);
+    }
+    int a, b;
+    long long c;
+};
+
+// Bounds of polygon in 8 directions at multiples of 45 degrees (k-DOP), that is ranges
+// of x, y, x + y and x - y over its vertices. Points and lines that are outside of
+// them are outside of polygon, so queries reject them in O(1)
+struct Bounds
+{
+    constexpr bool contains(const Point &p) const noexcept
+    {
+        return p.x >= minX && p.x <= maxX && p.y >= minY && p.y <= maxY &&
+               p.x + 1ll * p.y >= minSum && p.x + 1ll * p.y <= maxSum &&
+               p.x - 1ll * p.y >= minDiff && p.x - 1ll * p.y <= maxDiff;
+    }
+    // Checks if line crosses or touches bounding box
+    bool crosses(const Line &line) const noexcept
+    {
+        int sides = line.side(Point(minX, minY)) + line.side(Point(maxX, minY)) +
+                    line.side(Point(maxX, maxY)) + line.side(Point(minX, maxY));
+        return sides > -4 && sides < 4;
+    }
+    // Checks if bounds moved by shift overlap other ones, otherwise polygons do not intersect
+    bool overlaps(const Bounds &other, const Point &shift = Point(0, 0)) const noexcept
+    {
+        long long sum = shift.x + 1ll * shift.y, diff = shift.x - 1ll * shift.y;
+        return minX + 1ll * shift.x <= other.maxX && maxX + 1ll * shift.x >= other.minX &&
+               minY + 1ll * shift.y <= other.maxY && maxY + 1ll * shift.y >= other.minY &&
+               minSum + sum <= other.maxSum && maxSum + sum >= other.minSum &&
+               minDiff + diff <= other.maxDiff && maxDiff + diff >= other.minDiff;
+    }
+
+    // Indices of vertices that are extreme in directions (1, 0), (1, 1), (0, 1), (-1, 1)
+    // and so on counter-clockwise
+    int extremes[8];
+    int minX, maxX, minY, maxY;
+    long long minSum, maxSum, minDiff, maxDiff;
+};
+
+// View of count vertices of convex polygon that are stored contiguously elsewhere
+// in counter-clockwise order. Vertices are not copied, so they should not be destroyed
+// while view or polygon made from it is used
+struct PolygonView
+{
+    // Finds upmost and downmost vertices in O(count). Vertices can not be reversed
+    // in place, so ok is set to false if they are in clockwise order
+    PolygonView(const Point *points, int count, bool *ok = NULL);
+    // Finds bounds in O(log count)
+    PolygonView(const Point *points, int count, int upmost, int downmost);
+    PolygonView(const Point *points, int count, int upmost, int downmost, const Bounds &bounds);
+    const Point *points;
+    int count;
+    int downmost, upmost;
+    Bounds bounds;
+};
+
 // Structure that stores polygon in counter-clockwise order.
 // This polygon should be convex otherwise result of operations 
 // with it is undefined
 struct Polygon
 {
+    // Copies points, reversing them if they are in clockwise order
     Polygon(const std::vector <Point> &points);
+    // Takes ownership of points without copying them
+    Polygon(std::vector <Point> &&points);
+    // Polygon over vertices of view, they are not copied. Conversion is implicit,
+    // so every query on polygon accepts a view and it takes O(1) without allocation
+    Polygon(const PolygonView &view);
+    Polygon(const Polygon &other);
+    Polygon(Polygon &&other);
+    Polygon& operator = (const Polygon &other);
+    Polygon& operator = (Polygon &&other);
+    PolygonView view() const;
     const Point& operator [] (int i) const;
     void print(FILE *f = stdout) const;
     int size() const;
+    // Pointer to size() vertices stored contiguously in counter-clockwise order
+    const Point* data() const;
+    // Builds lookup tables of angles of the fan from poly[0] and of the sides.
+    // After that isInside, leftTangent, rightTangent and maximalPoint need O(1)
+    // expected time. If buckets == 0 then one bucket per vertex is used.
+    void buildAngularIndex(int buckets = 0);
+    bool hasAngularIndex() const;
+    // Builds copies of coordinates in separate arrays (structure of arrays).
+    // After that linear scans have no modulo in the loop and can be vectorized
+    void buildSoA();
+    bool hasSoA() const;
+    // Arrays of soaPadding + size() coordinates aligned by 32 bytes; element i
+    // is the coordinate of poly[i], so sides can be read without wrapping around.
+    // Only available after buildSoA()
+    const int* xs() const;
+    const int* ys() const;
+    static const int soaPadding = 8;
     int downmost, upmost;
+    // Found in O(log n) when polygon or view is constructed, so polygon made from
+    // view takes them from it
+    Bounds bounds;
+
+    // Fan of vectors from poly[0] to poly[1..size() - 1]; angles are counted from poly[1] - poly[0]
+    AngularIndex fanIndex;
+    // Sides poly[i + 1] - poly[i]; angles are counted from poly[1] - poly[0]
+    AngularIndex sideIndex;
+    // Mean of vertices and mean distance from it to vertices. Tangents are searched
+    // starting from vertices that would be tangent if polygon were such circle
+    PointDouble center;
+    double radius;
 
 private:
+    // Owned vertices, empty if they are stored elsewhere
     std::vector <Point> points;
-};
-
-struct Line
-{
-    // Constructs line through given two points
-    Line(const Point &first, const Point &second);
-    Point normal() const;
-    Point direction() const;
-    int a, b;
-    long long c;
+    std::vector <int, AlignedAllocator <int> > x, y;
+    const Point *vertices;
+    int count;
 };
 
 struct Segment
@@ -124,21 +360,63 @@ std::ostream& operator << (std::ostream &out, const SegmentDouble &segment);
 // The angle lies in [-PI, PI)
 bool compareByAngle(const Point &first, const Point &second);
 
+// Monotone function of the angle of vector with the horizontal axis.
+// It is cheaper than atan2 and lies in [0, 4)
+double pseudoAngle(const Point &vector);
+
 bool isInsideLinear(const Point &point, const Polygon &poly);
 bool isInside(const Point &point, const Polygon &poly, FILE *out = NULL);
+template <class Tracer> bool isInside(const Point &point, const Polygon &poly, Tracer &tracer);
 bool isInsideBS2(const Point &point, const Polygon &poly);
 
+// Checks every point from points[0..count-1] for being inside polygon and
+// writes results to result[0..count-1]. Results are the same as of isInsideLinear.
+// Several points are processed at once with AVX2 if processor supports it.
+void isInsideBatch(const Point *points, int count, const Polygon &poly, bool *result);
+// Same as isInsideBatch with results of isInside, but points are sorted by angle around
+// poly[0] and the fan of polygon is passed once with galloping, so it takes
+// O(count log count + min(n, count log n))
+void isInsideSorted(const Point *points, int count, const Polygon &poly, bool *result);
+
+// Functions that take FILE *out write slides for visualizer.py to it if it is not NULL.
+// They are also available as templates on tracer (NullTracer or SlideTracer, see
+// below), then tracing code is compiled only if Tracer::enabled is true.
+
 // Returns index of point in polygon such as line formed by this point
 // and point "from" is left tangent to given polygon. 
 // If point "from" is inside polygon then returning value is undefined.
 int leftTangentLinear(const Point &from, const Polygon &poly);
 int leftTangent(const Point &from, const Polygon &poly, FILE *out = NULL);
+template <class Tracer> int leftTangent(const Point &from, const Polygon &poly, Tracer &tracer);
 
 // Returns index of point in polygon such as line formed by this point
 // and point "from" is right tangent to given polygon. 
 // If point "from" is inside polygon then returning value is undefined.
 int rightTangentLinear(const Point &from, const Polygon &poly);
 int rightTangent(const Point &from, const Polygon &poly, FILE *out = NULL);
+template <class Tracer> int rightTangent(const Point &from, const Polygon &poly, Tracer &tracer);
+
+// Replaces points with vertices of their convex hull in counter-clockwise order starting
+// from the leftmost one. Points that lie on sides of the hull (see isOnSegment) are not
+// vertices. If all points lie on one line then only its ends (or one point) are left
+void hullVertices(std::vector <Point> &points);
+// Returns convex hull of points in O(n log n). Points may repeat and go in any order.
+// If ok != NULL then *ok is set to false if all points lie on one line, in this case
+// the polygon consists of less than 3 vertices, see hullVertices
+Polygon convexHull(std::vector <Point> points, bool *ok = NULL);
+
+// Rotating calipers, all of them take O(n).
+// Writes to result all pairs i < j of vertices through which parallel supporting lines go
+void antipodalPairs(const Polygon &poly, std::vector <std::pair <int, int> > &result);
+// Returns the largest distance between vertices and writes them to first and second if they are not NULL
+double diameter(const Polygon &poly, int *first = NULL, int *second = NULL);
+// Returns the smallest distance between parallel supporting lines. One of them goes through
+// side poly[side], poly[side + 1] and the other through vertex, they are written if not NULL
+double width(const Polygon &poly, int *side = NULL, int *vertex = NULL);
+// Return corners of the rectangle of minimal area or perimeter that contains polygon
+// in counter-clockwise order. One side of rectangle lies on a side of polygon
+std::vector <PointDouble> minAreaRectangle(const Polygon &poly);
+std::vector <PointDouble> minPerimeterRectangle(const Polygon &poly);
 
 bool isOnSegment(const Point &point, const Segment &segment);
 
@@ -152,16 +430,35 @@ double distance(const Point &point, const Segment &segment);
 
 double distanceLinear(const Point &point, const Polygon &poly);
 double distance(const Point &point, const Polygon &poly, FILE *out = NULL);
+// Also writes the point of polygon that is nearest to the given one to nearest and index i of
+// side poly[i], poly[i + 1] that contains it to side if they are not NULL. It takes two binary
+// searches one after another: for the left tangent and then for the nearest side after it.
+// For point that lies on polygon 0 is returned and side is undefined
+double distance(const Point &point, const Polygon &poly, PointDouble *nearest, int *side);
+template <class Tracer> double distance(const Point &point, const Polygon &poly, PointDouble *nearest, int *side, Tracer &tracer);
 
 // Returns index of point in polygon that has maximal projection on
 // vector dir 
 int maximalPointLinear(const Point &dir, const Polygon &poly);
 int maximalPoint(const Point &dir, const Polygon &poly, FILE *out = NULL);
+template <class Tracer> int maximalPoint(const Point &dir, const Polygon &poly, Tracer &tracer);
 
 // Returns index of point in polygon that has minimal projection on
 // vector dir 
 int minimalPointLinear(const Point &dir, const Polygon &poly);
 int minimalPoint(const Point &dir, const Polygon &poly, FILE *out = NULL);
+template <class Tracer> int minimalPoint(const Point &dir, const Polygon &poly, Tracer &tracer);
+
+// Same as isInside, leftTangent, rightTangent, maximalPoint and minimalPoint, but the answer
+// is searched by galloping from vertex hint, which is usually the answer for the previous
+// query of the same object. They take O(log d), where d is the distance from hint to the
+// answer, and O(log n) at worst. isInside writes to hint the vertex l of its fan triangle
+// poly[0], poly[l], poly[l + 1], which is the hint for the next query
+bool isInside(const Point &point, const Polygon &poly, int &hint);
+int leftTangent(const Point &from, const Polygon &poly, int hint);
+int rightTangent(const Point &from, const Polygon &poly, int hint);
+int maximalPoint(const Point &dir, const Polygon &poly, int hint);
+int minimalPoint(const Point &dir, const Polygon &poly, int hint);
 
 // Returns intersection of two lines if they are not parallel to each other,
 // otherwise returning value is undefined.
@@ -175,28 +472,147 @@ PointDouble intersection(const Line &first, const Line &second, bool *ok = 0, FI
 // or false otherwise
 SegmentDouble intersectionLinear(const Line &line, const Polygon &poly, bool *ok = NULL);
 SegmentDouble intersection(const Line &line, const Polygon &poly, bool *ok = NULL, FILE *out = NULL);
+template <class Tracer> SegmentDouble intersection(const Line &line, const Polygon &poly, bool *ok, Tracer &tracer);
+
+// Returns vertices of intersection of two polygons in counter-clockwise order in O(n + m).
+// It is empty if polygons do not intersect and has less than 3 vertices if they only touch.
+// Vertices are found as crossings of sides, so they are computed with relative error about eps
+std::vector <PointDouble> intersection(const Polygon &first, const Polygon &second);
+// Checks that polygons have a common point in O(log n log m), or in O(log n) expected time
+// if second has angular index. Points of Minkowski difference may be twice as large as
+// coordinates, so products of them are exact only if compiler supports 128-bit integers
+bool isIntersection(const Polygon &first, const Polygon &second);
+
+// Returns Minkowski sum of two polygons in O(n + m). Coordinates of the sum should not
+// exceed 2^30 by an absolute value
+Polygon minkowskiSum(const Polygon &first, const Polygon &second);
+// Checks that first moved by shift has a common point with second in O(log n log m).
+// The Minkowski difference of second and first is not built
+bool isCollision(const Polygon &first, const Point &shift, const Polygon &second);
+// Returns the length of the shortest move of first moved by shift along dir that
+// separates it from second, or 0 if they do not intersect by interior points.
+// Works in O(log n log m) over the Minkowski difference that is not built
+double penetrationDepth(const Polygon &first, const Point &shift, const Polygon &second, const Point &dir);
+// Returns distance between polygons in O(log n log m) and writes their nearest points to
+// firstNearest and secondNearest if they are not NULL. If polygons intersect then 0 is
+// returned and nearest points are not written
+double distance(const Polygon &first, const Polygon &second, PointDouble *firstNearest = NULL, PointDouble *secondNearest = NULL);
+// Returns line such that a * x + b * y + c < 0 for all points of first and >= 0 for all
+// points of second, its normal is a normal of a side of one of polygons.
+// If polygons intersect then returning value is undefined.
+// If ok != NULL then *ok is set to false if polygons intersect or to true otherwise
+Line separatingLine(const Polygon &first, const Polygon &second, bool *ok = NULL);
+
+// Returns random strictly convex polygon with vcnt >= 3 vertices, coordinates of which
+// do not exceed radius by an absolute value (radius is decreased to 2^30 - 1 if it is larger).
+// Vertices are built by Valtr's method: sides are random vectors with zero sum sorted by angle.
+// radius is increased to vcnt^1.5 / 4 if it is smaller, so vcnt should not exceed 2.6 * 10^6.
+// The same seed gives the same polygon; the version without seed takes it from rand()
+Polygon genLargePolygon(int vcnt, double radius = RAND_MAX);
+Polygon genLargePolygon(int vcnt, double radius, unsigned long long seed);
+
+// Trace for visualizer.py is a sequence of commands, one per line:
+//   point, segment, vector, ray, line, angle - draw a figure, see the draw functions below
+//   print text - shows text on the slide
+//   polygon n x0 y0 ... - declares polygon that is used by following state commands
+//   state l m r - draws declared polygon with sides l..r-1 highlighted and
+//                 vertices l, m, r labeled, -1 means that there is no such vertex
+//   wait - ends step of slide, end - ends slide
+// So polygon is written once and every step of binary search needs O(1) space.
+
+// Buffered writer of trace. Numbers are formatted without printf and the
+// buffer is written to file when it is full or when writer is destroyed
+struct TraceWriter
+{
+    TraceWriter(FILE *out);
+    TraceWriter(const TraceWriter&) = delete;
+    TraceWriter& operator = (const TraceWriter&) = delete;
+    ~TraceWriter();
+    TraceWriter& operator << (const char *s);
+    TraceWriter& operator << (char c);
+    TraceWriter& operator << (int a);
+    TraceWriter& operator << (long long a);
+    TraceWriter& operator << (double a);
+    void flush();
+
+private:
+    static const int capacity = 1 << 16;
+    FILE *out;
+    char buffer[capacity];
+    int size;
+};
 
+void drawPoint(TraceWriter &out, const Point& point, const char *name = "");
 
-Polygon genLargePolygon(int vcnt, double radius = RAND_MAX);                                               
+void drawPoint(TraceWriter &out, const PointDouble& point, const char *name = "");
 
-void drawPoint(FILE *out, const Point& point, const char *name = "");
+void drawSegment(TraceWriter &out, const Point &from, const Point &to, const char* color, const char* name = "");
 
-void drawPoint(FILE *out, const PointDouble& point, const char *name = "");
+void drawVector(TraceWriter &out, const Point &from, const Point &to, const char* color, const char* name = "");
 
-void drawSegment(FILE *out, const Point &from, const Point &to, const char* color, const char* name = "");
+void drawRay(TraceWriter &out, const Point &from, const Point &dir, const char* color, const char* name = "");
 
-void drawVector(FILE *out, const Point &from, const Point &to, const char* color, const char* name = "");
+void drawLine(TraceWriter &out, const Line &line, const char* color);
 
-void drawRay(FILE *out, const Point &from, const Point &dir, const char* color, const char* name = "");
+void drawAngle(TraceWriter &out, const Point &vertex, const Point &first, const Point &second, bool withArc = 0);
 
-void drawLine(FILE *out, const Line &line, const char* color);
+void drawPolygon(TraceWriter &out, const Polygon &poly);
 
-void drawAngle(FILE *out, const Point &vertex, const Point &first, const Point &second, bool withArc = 0);
+void drawState(TraceWriter &out, int l, int m, int r);
 
-void drawText(FILE *out, const char *text);
+void drawText(TraceWriter &out, const char *text);
 
-void endOfSlide(FILE *out);
+void endOfSlide(TraceWriter &out);
 
-void endOfStep(FILE *out);
+void endOfStep(TraceWriter &out);
+
+// Tracer that does nothing, so traced algorithms compile to the plain ones
+struct NullTracer
+{
+    static const bool enabled = false;
+    void drawPoint(const Point&, const char* = "") {}
+    void drawPoint(const PointDouble&, const char* = "") {}
+    void drawSegment(const Point&, const Point&, const char*, const char* = "") {}
+    void drawVector(const Point&, const Point&, const char*, const char* = "") {}
+    void drawRay(const Point&, const Point&, const char*, const char* = "") {}
+    void drawLine(const Line&, const char*) {}
+    void drawAngle(const Point&, const Point&, const Point&, bool = 0) {}
+    void drawBinSearchState(const Polygon&, int, int, int) {}
+    void drawText(const char*) {}
+    void endOfSlide() {}
+    void endOfStep() {}
+};
+
+// Tracer that writes slides for visualizer.py with the draw functions above
+struct SlideTracer
+{
+    static const bool enabled = true;
+    SlideTracer(FILE *out) : writer(out), polygon(NULL) {}
+    void drawPoint(const Point &point, const char *name = "") { ::drawPoint(writer, point, name); }
+    void drawPoint(const PointDouble &point, const char *name = "") { ::drawPoint(writer, point, name); }
+    void drawSegment(const Point &from, const Point &to, const char *color, const char *name = "") { ::drawSegment(writer, from, to, color, name); }
+    void drawVector(const Point &from, const Point &to, const char *color, const char *name = "") { ::drawVector(writer, from, to, color, name); }
+    void drawRay(const Point &from, const Point &dir, const char *color, const char *name = "") { ::drawRay(writer, from, dir, color, name); }
+    void drawLine(const Line &line, const char *color) { ::drawLine(writer, line, color); }
+    void drawAngle(const Point &vertex, const Point &first, const Point &second, bool withArc = 0) { ::drawAngle(writer, vertex, first, second, withArc); }
+    void drawText(const char *text) { ::drawText(writer, text); }
+    void endOfSlide() { ::endOfSlide(writer); }
+    void endOfStep() { ::endOfStep(writer); }
+
+    // Draws polygon with the range of binary search, polygon is declared
+    // only when it differs from the previous one
+    void drawBinSearchState(const Polygon &poly, int l, int m, int r)
+    {
+        if (polygon != &poly)
+        {
+            ::drawPolygon(writer, poly);
+            polygon = &poly;
+        }
+        ::drawState(writer, l, m, r);
+    }
+
+    TraceWriter writer;
+    const Polygon *polygon;
+};
 
 #endif
@@ -0,0 +1,121 @@
+#include "polygonfile.h"
+#include <cstring>
+#include <algorithm>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+using namespace std;
+
+// Vertices are written and mapped as they are stored in Polygon
+static_assert(sizeof(Point) == 2 * sizeof(int32_t), "Point should consist of two 32-bit integers");
+static_assert(sizeof(PolygonFileHeader) % alignof(Point) == 0, "Vertices should be aligned after header");
+
+static const char polygonMagic[8] = {'P', 'O', 'L', 'Y', 'G', 'O', 'N', 0};
+
+uint64_t polygonChecksum(const Point *points, int count)
+{
+    uint64_t result = 14695981039346656037ull;
+    for (int i = 0; i < count; i++)
+    {
+        uint64_t word = (uint64_t) (uint32_t) points[i].x | (uint64_t) (uint32_t) points[i].y << 32;
+        result = (result ^ word) * 1099511628211ull;
+    }
+    return result;
+}
+
+// Fills all fields of header that are found from vertices: count, upmost, downmost,
+// bounding box and checksum. Writing and verifying file use it, so they agree in ties
+static void describePolygon(const Point *points, int count, PolygonFileHeader &header)
+{
+    PolygonView view(points, count);
+    header.count = (uint32_t) count;
+    header.upmost = view.upmost;
+    header.downmost = view.downmost;
+    header.minX = header.maxX = points[0].x;
+    header.minY = points[view.downmost].y;
+    header.maxY = points[view.upmost].y;
+    for (int i = 0; i < count; i++)
+    {
+        header.minX = min(header.minX, points[i].x);
+        header.maxX = max(header.maxX, points[i].x);
+    }
+    header.checksum = polygonChecksum(points, count);
+}
+
+bool savePolygon(const char *path, const Polygon &poly)
+{
+    PolygonFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, polygonMagic, sizeof(polygonMagic));
+    header.version = PolygonFileHeader::currentVersion;
+    describePolygon(poly.data(), poly.size(), header);
+
+    FILE *f = fopen(path, "wb");
+    if (!f)
+        return 0;
+    bool result = fwrite(&header, sizeof(header), 1, f) == 1 &&
+                  fwrite(poly.data(), sizeof(Point), poly.size(), f) == (size_t) poly.size();
+    return fclose(f) == 0 && result;
+}
+
+inline void setOk(bool *ok, int res)
+{
+    if (ok)
+        *ok = res;
+}
+
+MappedPolygon::MappedPolygon(const char *path, bool *ok, bool verify) :
+    memory(NULL), length(0), poly(PolygonView(NULL, 0, 0, 0))
+{
+    setOk(ok, 0);
+    int fd = open(path, O_RDONLY);
+    if (fd == -1)
+        return;
+    struct stat info;
+    if (fstat(fd, &info) == 0 && (size_t) info.st_size >= sizeof(PolygonFileHeader))
+    {
+        length = (size_t) info.st_size;
+        memory = mmap(NULL, length, PROT_READ, MAP_SHARED, fd, 0);
+        if (memory == MAP_FAILED)
+            memory = NULL;
+    }
+    // Mapping stays valid after the file is closed
+    close(fd);
+    if (!memory)
+        return;
+
+    const PolygonFileHeader &head = header();
+    if (memcmp(head.magic, polygonMagic, sizeof(polygonMagic)) != 0 ||
+        head.version != PolygonFileHeader::currentVersion || head.count < 3 || head.count > (1u << 30) ||
+        length != sizeof(PolygonFileHeader) + (size_t) head.count * sizeof(Point) ||
+        head.upmost < 0 || head.upmost >= (int32_t) head.count || head.downmost < 0 || head.downmost >= (int32_t) head.count)
+        return;
+    const Point *points = (const Point*) ((const char*) memory + sizeof(PolygonFileHeader));
+    if (verify)
+    {
+        PolygonFileHeader expected = head;
+        describePolygon(points, (int) head.count, expected);
+        if (memcmp(&expected, &head, sizeof(head)) != 0)
+            return;
+    }
+    poly = Polygon(PolygonView(points, (int) head.count, head.upmost, head.downmost));
+    setOk(ok, 1);
+}
+
+MappedPolygon::~MappedPolygon()
+{
+    if (memory)
+        munmap(memory, length);
+}
+
+const Polygon& MappedPolygon::polygon() const
+{
+    return poly;
+}
+
+const PolygonFileHeader& MappedPolygon::header() const
+{
+    return *(const PolygonFileHeader*) memory;
+}
@@ -0,0 +1,54 @@
+#ifndef POLYGONFILE_H
+#define POLYGONFILE_H
+
+#include "geometry.h"
+#include <cstdint>
+
+// Binary file with one polygon. It starts with the header, after which there are
+// count vertices in counter-clockwise order, each is x and y as 32-bit integers in
+// native byte order. So vertices can be mapped to memory and used as they are
+struct PolygonFileHeader
+{
+    static const uint32_t currentVersion = 1;
+
+    char magic[8];
+    uint32_t version, count;
+    int32_t upmost, downmost;
+    // Bounding box of vertices
+    int32_t minX, minY, maxX, maxY;
+    // Checksum of vertices, see polygonChecksum
+    uint64_t checksum;
+};
+
+// FNV-1a over 64-bit words, each word is one vertex
+uint64_t polygonChecksum(const Point *points, int count);
+
+// Writes polygon to file in binary format. Returns false if file can not be written
+bool savePolygon(const char *path, const Polygon &poly);
+
+// Polygon file mapped to memory. Vertices are not copied and are read by the system
+// only when queries touch them, so polygon of any size is opened in O(1) if checksum
+// is not verified and in one pass over the file otherwise
+struct MappedPolygon
+{
+    // If ok != NULL then *ok is set to false if file can not be mapped, it is not a
+    // polygon file or (if verify is true) checksum, extreme vertices or bounding box
+    // do not match vertices, or to true otherwise. In the first three cases polygon()
+    // must not be used
+    MappedPolygon(const char *path, bool *ok = NULL, bool verify = 1);
+    ~MappedPolygon();
+
+    // Polygon over the mapped vertices, it is valid while this object exists
+    const Polygon& polygon() const;
+    const PolygonFileHeader& header() const;
+
+private:
+    MappedPolygon(const MappedPolygon&);
+    MappedPolygon& operator = (const MappedPolygon&);
+
+    void *memory;
+    size_t length;
+    Polygon poly;
+};
+
+#endif
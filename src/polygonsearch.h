@@ -0,0 +1,354 @@
+#ifndef POLYGONSEARCH_H
+#define POLYGONSEARCH_H
+
+#include "stats.h"
+
+// Binary searches over vertices of convex polygon that are written once for all kinds
+// of polygons: Polygon, BasicPolygon and the Minkowski difference of two polygons that
+// is not built. Vertices are compared only through signs of products, so the type of
+// coordinates and the way vertex i is found do not matter. Indices are taken modulo n.
+// draw functions are called only if Tracer::enabled
+
+// Left tangent from point to polygon with n vertices, vertex(i) returns poly[i] - point and
+// cross(a, b) has the sign of a % b. draw(l, m, r, i, j) draws state of the search and
+// the angle between vertices i and j if they are not -1
+template <class Tracer, class Vertex, class Cross, class Draw> int leftTangentSearch(int n, const Vertex &vertex, const Cross &cross, const Draw &draw,
+                                                                      StatsScope &stats, Tracer &tracer)
+{
+    int l = 0, r = n, m;
+    while (r - l > 1)
+    {
+        stats.iteration();
+        m = (l + r) / 2;
+        if (Tracer::enabled)
+            draw(l, m, r, -1, -1);
+        auto vl = vertex(l);
+        auto lTurn = cross(vertex(l + 1), vl);
+        if (lTurn == 0)
+        {
+            stats.event(STATS_COLLINEAR_SKIP);
+            l++;
+            if (Tracer::enabled)
+            {
+                tracer.drawText("Так как угол равен нулю, то, чтобы избежать крайних случаев,\\n\
+двигаем левый указатель на 1");
+                tracer.endOfSlide();
+            }
+            continue;
+        }
+        if (lTurn > 0 && cross(vl, vertex(l - 1)) <= 0)
+        {
+            if (Tracer::enabled)
+            {
+                tracer.drawText("Поскольку вершина, на которую указывает l, является точкой касания,\\n\
+то выходим из цикла бинпоиска");
+                tracer.endOfSlide();
+            }
+            stats.event(STATS_EARLY_EXIT);
+            r = l + 1;
+            break;
+        }
+        if (Tracer::enabled)
+        {
+            tracer.endOfStep();
+            draw(l, m, r, l, l + 1);
+            tracer.drawText("Смотрим на знак производной");
+            tracer.endOfStep();
+        }
+        if (lTurn < 0)
+        {
+            if (Tracer::enabled)
+            {
+                tracer.drawText("Она больше нуля. Теперь посмотрим на знак производной в вершине m");
+                tracer.endOfSlide();
+                draw(l, m, r, m, m + 1);
+            }
+            auto vm = vertex(m);
+            if (cross(vertex(m + 1), vm) > 0)
+            {
+                if (Tracer::enabled)
+                {
+                    tracer.drawText("Так как в вершине m она меньше нуля, то двигаем правую границу");
+                    tracer.endOfSlide();
+                }
+                r = m;
+            }
+            else
+            {
+                if (Tracer::enabled)
+                {
+                    tracer.drawText("Она больше нуля, поэтому надо сравнить углы до вершин l и m");
+                    tracer.endOfSlide();
+                    draw(l, m, r, l, m);
+                }
+                if (cross(vl, vm) < 0)
+                {
+                    if (Tracer::enabled)
+                        tracer.drawText("Так как вершина l \"выше\" вершина m, то двигаем правый указатель");
+                    r = m;
+                }
+                else
+                {
+                    if (Tracer::enabled)
+                        tracer.drawText("Так как вершина m \"выше\" вершина l, то двигаем левый указатель");
+                    l = m;
+                }
+                if (Tracer::enabled)
+                    tracer.endOfSlide();
+            }
+        }
+        else
+        {
+            if (Tracer::enabled)
+            {
+                tracer.drawText("Она меньше нуля. Теперь посмотрим на знак производной в вершине m");
+                tracer.endOfSlide();
+                draw(l, m, r, m, m + 1);
+            }
+            auto vm = vertex(m);
+            if (cross(vertex(m + 1), vm) <= 0)
+            {
+                if (Tracer::enabled)
+                {
+                    tracer.drawText("Так как в вершине m она больше нуля, то двигаем левую границу");
+                    tracer.endOfSlide();
+                }
+                l = m;
+            }
+            else
+            {
+                if (Tracer::enabled)
+                {
+                    tracer.drawText("Она меньше нуля, поэтому надо сравнить углы до вершин l и m");
+                    tracer.endOfSlide();
+                    draw(l, m, r, l, m);
+                }
+                if (cross(vl, vm) >= 0)
+                {
+                    if (Tracer::enabled)
+                        tracer.drawText("Так как вершина l \"ниже\" вершина m, то двигаем правый указатель");
+                    r = m;
+                }
+                else
+                {
+                    if (Tracer::enabled)
+                        tracer.drawText("Так как вершина l \"выше\" вершина m, то двигаем левый указатель");
+                    l = m;
+                }
+                if (Tracer::enabled)
+                    tracer.endOfSlide();
+            }
+        }
+    }
+    return cross(vertex(r), vertex(r - 1)) <= 0 ? r : l;
+}
+
+// Right tangent from point to polygon with n vertices, vertex and cross are the same as in leftTangentSearch
+template <class Vertex, class Cross> int rightTangentSearch(int n, const Vertex &vertex, const Cross &cross, StatsScope &stats)
+{
+    int l = 0, r = n, m;
+    while (r - l > 1)
+    {
+        stats.iteration();
+        m = (l + r) / 2;
+        auto vl = vertex(l);
+        auto lTurn = cross(vertex(l + 1), vl);
+        if (lTurn == 0)
+        {
+            stats.event(STATS_COLLINEAR_SKIP);
+            l++;
+            continue;
+        }
+        if (lTurn < 0 && cross(vl, vertex(l - 1)) >= 0)
+        {
+            stats.event(STATS_EARLY_EXIT);
+            return l;
+        }
+        auto vm = vertex(m);
+        if (lTurn < 0)
+        {
+            if (cross(vertex(m + 1), vm) >= 0)
+                l = m;
+            else
+            {
+                if (cross(vl, vm) <= 0)
+                    r = m;
+                else
+                    l = m;
+            }
+        }
+        else
+        {
+            if (cross(vertex(m + 1), vm) < 0)
+                r = m;
+            else
+            {
+                if (cross(vl, vm) >= 0)
+                    r = m;
+                else
+                    l = m;
+            }
+        }
+    }
+    return cross(vertex(r), vertex(r - 1)) >= 0 ? r : l;
+}
+
+// Vertex of polygon with n vertices that is maximal along direction dir, vertex(i) returns
+// poly[i] and progress(a, b) has the sign of (a - b) * dir. draw(l, m, r) draws state of
+// the search and drawAngle(i) draws the angle between dir and side from vertex i - 1 to i
+template <class Tracer, class Vertex, class Progress, class Draw, class DrawAngle> int maximalPointSearch(int n,
+    const Vertex &vertex, const Progress &progress, const Draw &draw, const DrawAngle &drawAngle, StatsScope &stats, Tracer &tracer)
+{
+    int l = 0, r = n, m;
+    while (r - l > 1)
+    {
+        stats.iteration();
+        m = (l + r) / 2;
+        if (Tracer::enabled)
+        {
+            draw(l, m, r);
+            tracer.endOfStep();
+            tracer.drawText("Посмотрим на знак скалярного произведения вектора из вершины l-1 в вершину l\\n\
+и вектора направления");
+            drawAngle(l);
+            tracer.endOfStep();
+        }
+        auto vl = vertex(l);
+        auto lDir = progress(vl, vertex(l - 1));
+        if (lDir == 0)
+        {
+            if (progress(vertex(l + 1), vl) < 0)
+            {
+                if (Tracer::enabled)
+                {
+                    tracer.drawText("Поскольку оно равно нулю и при этом скалярное произведение вектора направления и следующей стороны\\n\
+меньше нуля, то эта вершина имеет максимальную проекцию");
+                    tracer.endOfSlide();
+                }
+                stats.event(STATS_EARLY_EXIT);
+                break;
+            }
+            else
+            {
+                if (Tracer::enabled)
+                {
+                    tracer.drawText("Поскольку оно равно нулю и при этом скалярное произведение вектора направления и следующей стороны\\n\
+больше нуля, то просто двигаем левый указатель на 1 вправо");
+                    tracer.endOfSlide();
+                }
+                stats.event(STATS_COLLINEAR_SKIP);
+                l++;
+                continue;
+            }
+        }
+        if (lDir > 0)
+        {
+            if (Tracer::enabled)
+            {
+                draw(l, m, r);
+                tracer.drawText("Оно больше нуля. Теперь посмотрим на скалярное произведение вектора направления и\\n\
+вектора из точки m-1 в точку m");
+                drawAngle(m);
+                tracer.endOfStep();
+            }
+            auto vm = vertex(m);
+            if (progress(vm, vertex(m - 1)) < 0)
+            {
+                if (Tracer::enabled)
+                    tracer.drawText("Так как оно меньше нуля, то двигаем правый указатель");
+                r = m;
+            }
+            else if (progress(vm, vl) >= 0)
+            {
+                if (Tracer::enabled)
+                    tracer.drawText("Так как оно больше нуля, и при этом вершина m находится дальше по направлению, то\\n\
+двигаем левый указатель");
+                l = m;
+            }
+            else
+            {
+                if (Tracer::enabled)
+                    tracer.drawText("Так как оно больше нуля, и при этом вершина l находится дальше по направлению, то\\n\
+двигаем правый указатель");
+                r = m;
+            }
+            if (Tracer::enabled)
+                tracer.endOfSlide();
+        }
+        else
+        {
+            if (Tracer::enabled)
+            {
+                draw(l, m, r);
+                tracer.drawText("Оно меньше нуля. Теперь посмотрим на скалярное произведение вектора направления и\\n\
+вектора из точки m-1 в точку m");
+                drawAngle(m);
+                tracer.endOfStep();
+            }
+            auto vm = vertex(m);
+            if (progress(vm, vertex(m - 1)) >= 0)
+            {
+                if (Tracer::enabled)
+                    tracer.drawText("Так как оно больше нуля, то двигаем левый указатель");
+                l = m;
+            }
+            else if (progress(vm, vl) <= 0)
+            {
+                if (Tracer::enabled)
+                    tracer.drawText("Так как оно меньше нуля, и при этом вершина l находится дальше по направлению, то\\n\
+двигаем левый указатель");
+                l = m;
+            }
+            else
+            {
+                if (Tracer::enabled)
+                    tracer.drawText("Так как оно больше нуля, и при этом вершина m находится дальше по направлению, то\\n\
+двигаем левый указатель");
+                r = m;
+            }
+            if (Tracer::enabled)
+                tracer.endOfSlide();
+        }
+    }
+    return l;
+}
+
+// Last vertex l in [l, r) of the fan from vertex 0 such that point is not to the left of
+// the ray from vertex 0 to it, right(m) has the sign of (point - poly[0]) % (poly[m] - poly[0]).
+// draw(l, m, r) draws state of the search and drawAngle(m) draws the angle between point and vertex m
+template <class Tracer, class Right, class Draw, class DrawAngle> int fanSearch(int l, int r, const Right &right,
+    const Draw &draw, const DrawAngle &drawAngle, StatsScope &stats, Tracer &tracer)
+{
+    while (r - l > 1)
+    {
+        stats.iteration();
+        int m = (l + r) / 2;
+        if (Tracer::enabled)
+        {
+            draw(l, m, r);
+            tracer.endOfStep();
+            tracer.drawText("Смотрим на векторное произведение вектора из нулевой точки многоугольника до\\nвершины m и вектора до данной точки");
+            drawAngle(m);
+            tracer.endOfStep();
+        }
+        if (right(m) <= 0)
+        {
+            if (Tracer::enabled)
+                tracer.drawText("Так как точка лежит правее вершины (по обходу против часовой стрелки),\\n\
+то двигаем левый указатель");
+            l = m;
+        }
+        else
+        {
+            if (Tracer::enabled)
+                tracer.drawText("Так как точка лежит левее вершины (по обходу против часовой стрелки),\\n\
+то двигаем правый указатель");
+            r = m;
+        }
+        if (Tracer::enabled)
+            tracer.endOfSlide();
+    }
+    return l;
+}
+
+#endif
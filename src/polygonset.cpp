@@ -0,0 +1,140 @@
+#include "polygonset.h"
+#include <algorithm>
+
+using namespace std;
+
+bool PolygonSet::Box::contains(const Point &point) const
+{
+    return point.x >= minX && point.x <= maxX && point.y >= minY && point.y <= maxY;
+}
+
+PolygonSet::PolygonSet(const vector <Polygon> &p) : polygons(p)
+{
+    for (auto &poly : polygons)
+    {
+        // Bounding box is taken from bounds of polygon, so big polygons are not scanned
+        Box box;
+        box.minX = poly.bounds.minX;
+        box.maxX = poly.bounds.maxX;
+        box.minY = poly.bounds.minY;
+        box.maxY = poly.bounds.maxY;
+        boxes.push_back(box);
+        order.push_back((int) order.size());
+    }
+    if (!polygons.empty())
+        build(0, size());
+}
+
+int PolygonSet::size() const
+{
+    return (int) polygons.size();
+}
+
+const Polygon& PolygonSet::operator [] (int i) const
+{
+    return polygons[i];
+}
+
+int PolygonSet::build(int from, int to)
+{
+    int id = (int) nodes.size();
+    Node node;
+    node.box = boxes[order[from]];
+    for (int i = from + 1; i < to; i++)
+    {
+        const Box &box = boxes[order[i]];
+        node.box.minX = min(node.box.minX, box.minX);
+        node.box.minY = min(node.box.minY, box.minY);
+        node.box.maxX = max(node.box.maxX, box.maxX);
+        node.box.maxY = max(node.box.maxY, box.maxY);
+    }
+    node.right = -1;
+    node.from = from;
+    node.to = to;
+    nodes.push_back(node);
+    if (to - from <= leafSize)
+        return id;
+
+    bool byX = (long long) node.box.maxX - node.box.minX >= (long long) node.box.maxY - node.box.minY;
+    int middle = (from + to) / 2;
+    nth_element(order.begin() + from, order.begin() + middle, order.begin() + to, [&](int a, int b)
+    {
+        // Doubled centers are compared, so they are integer
+        const Box &first = boxes[a], &second = boxes[b];
+        if (byX)
+            return (long long) first.minX + first.maxX < (long long) second.minX + second.maxX;
+        return (long long) first.minY + first.maxY < (long long) second.minY + second.maxY;
+    });
+    build(from, middle);
+    int right = build(middle, to);
+    nodes[id].right = right;
+    return id;
+}
+
+template <class Check> void PolygonSet::visit(const Point &point, Check check) const
+{
+    if (nodes.empty())
+        return;
+    // Depth of the tree is O(log N) as it is split by medians
+    int stack[64], top = 0;
+    stack[top++] = 0;
+    while (top)
+    {
+        int id = stack[--top];
+        const Node &node = nodes[id];
+        if (!node.box.contains(point))
+            continue;
+        if (node.right == -1)
+        {
+            for (int i = node.from; i < node.to; i++)
+                if (boxes[order[i]].contains(point))
+                    check(order[i]);
+        }
+        else
+        {
+            stack[top++] = node.right;
+            stack[top++] = id + 1;
+        }
+    }
+}
+
+int PolygonSet::find(const Point &point) const
+{
+    int result = -1;
+    visit(point, [&](int i)
+    {
+        if ((result == -1 || i < result) && isInside(point, polygons[i]))
+            result = i;
+    });
+    return result;
+}
+
+void PolygonSet::findAll(const Point &point, vector <int> &result) const
+{
+    result.clear();
+    visit(point, [&](int i)
+    {
+        if (isInside(point, polygons[i]))
+            result.push_back(i);
+    });
+    sort(result.begin(), result.end());
+}
+
+// Interleaves bits of coordinates shifted to be non-negative
+inline unsigned long long zOrder(const Point &point)
+{
+    unsigned long long x = (unsigned) point.x + (1u<<31), y = (unsigned) point.y + (1u<<31), result = 0;
+    for (int bit = 31; bit >= 0; bit--)
+        result = (result << 2) | (((x >> bit) & 1) << 1) | ((y >> bit) & 1);
+    return result;
+}
+
+void PolygonSet::find(const Point *points, int count, int *result) const
+{
+    vector <pair <unsigned long long, int> > keys(count);
+    for (int i = 0; i < count; i++)
+        keys[i] = make_pair(zOrder(points[i]), i);
+    sort(keys.begin(), keys.end());
+    for (auto &key : keys)
+        result[key.second] = find(points[key.second]);
+}
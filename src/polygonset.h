@@ -0,0 +1,52 @@
+#ifndef POLYGONSET_H
+#define POLYGONSET_H
+
+#include "geometry.h"
+#include <vector>
+
+// Set of convex polygons with bounding volume hierarchy over their bounding boxes.
+// Point query visits O(log N + k) nodes, where k is the number of boxes that
+// contain the point, and checks only these k polygons with isInside
+struct PolygonSet
+{
+    // Bulk loads polygons. Tree is built top-down, every node is split by the
+    // median of box centers along the longer side of its box
+    PolygonSet(const std::vector <Polygon> &polygons);
+    int size() const;
+    const Polygon& operator [] (int i) const;
+
+    // Returns minimal index of polygon that contains point or -1 if there is no such polygon
+    int find(const Point &point) const;
+    // Same as find for points[0..count-1]. Points are processed in Z-order, so
+    // queries that are close to each other go through the same nodes
+    void find(const Point *points, int count, int *result) const;
+    // Writes indices of all polygons that contain point to result in increasing order
+    void findAll(const Point &point, std::vector <int> &result) const;
+
+private:
+    struct Box
+    {
+        int minX, minY, maxX, maxY;
+        bool contains(const Point &point) const;
+    };
+
+    // Children of inner node are node + 1 and right. Leaf stores polygons
+    // order[from..to-1] and has right == -1
+    struct Node
+    {
+        Box box;
+        int right, from, to;
+    };
+
+    static const int leafSize = 4;
+    int build(int from, int to);
+    // Calls check(polygon) for every polygon whose box contains point
+    template <class Check> void visit(const Point &point, Check check) const;
+
+    std::vector <Polygon> polygons;
+    std::vector <Box> boxes;
+    std::vector <int> order;
+    std::vector <Node> nodes;
+};
+
+#endif
@@ -0,0 +1,326 @@
+#include "geometry.h"
+#include "polygonfile.h"
+#include "stats.h"
+#include <cstring>
+#include <vector>
+
+using namespace std;
+
+// Answers queries to one polygon, one answer per line:
+//   inside x y    1 if point is inside polygon or on its border, 0 otherwise
+//   dist x y      distance from point to polygon, 0 for point inside it
+//   tangent x y   indices of vertices of left and right tangents, -1 -1 for point inside
+//   line a b c    ends of segment where line a * x + b * y + c = 0 crosses polygon, or none
+//   stats         counters of previous queries in JSON (see stats.h), zero unless
+//                 query.exe is built with DEFINES=-DGEOMETRY_STATS
+// Input starts with the number of vertices and vertices of polygon, then queries go.
+// Usage: query.exe [input [polygon.bin]]
+// Input is read from stdin if it is not given or is "-". If polygon file in binary
+// format is given (see polygonfile.h), then polygon is mapped from it and input
+// contains only queries. Unknown, malformed or truncated query is reported to stderr
+// and the program exits with code 1
+
+const size_t bufferSize = 1 << 16;
+// Coordinates of points and coefficients a, b should not exceed 2^30 - 1 by an absolute
+// value (see geometry.h), then a * x + b * y + c fits in 64 bits if |c| < 2^61
+const long long maxCoordinate = (1 << 30) - 1, maxFreeTerm = (1ll << 61) - 1;
+
+// Buffered reader of words and integers separated by whitespace
+struct Input
+{
+    Input(FILE *_f) : f(_f), from(0), to(0), end(0), failed(0)
+    {
+        buffer[0] = 0;
+    }
+
+    // Makes at least lookahead characters available unless input ends. Tokens are
+    // shorter, so they are parsed without checks for the end of buffer, which is
+    // followed by zero
+    void fill()
+    {
+        if (to - from >= lookahead || end)
+            return;
+        memmove(buffer, buffer + from, to - from);
+        to -= from;
+        from = 0;
+        size_t count = fread(buffer + to, 1, bufferSize - to, f);
+        end = count == 0;
+        to += count;
+        buffer[to] = 0;
+    }
+
+    // Returns false at the end of input
+    bool skipSpaces()
+    {
+        while (1)
+        {
+            fill();
+            while (from < to && (unsigned char) buffer[from] <= ' ')
+                from++;
+            if (from < to)
+            {
+                fill();
+                return 1;
+            }
+            if (end)
+                return 0;
+        }
+    }
+
+    // Reads word of at most size - 1 characters, the rest of it is skipped.
+    // Returns false at the end of input
+    bool readWord(char *word, size_t size)
+    {
+        if (!skipSpaces())
+            return 0;
+        size_t length = 0;
+        while ((unsigned char) buffer[from] > ' ')
+        {
+            if (length + 1 < size)
+                word[length++] = buffer[from];
+            from++;
+            if (from == to)
+                fill();
+        }
+        word[length] = 0;
+        return 1;
+    }
+
+    // Reads integer whose absolute value is at most limit. If input ends, the word
+    // is not an integer or it is out of range, then failed is set and 0 is returned
+    long long readInt(long long limit)
+    {
+        if (!skipSpaces())
+        {
+            failed = 1;
+            return 0;
+        }
+        const char *p = buffer + from;
+        bool negative = *p == '-';
+        if (negative)
+            p++;
+        const char *digits = p;
+        long long result = 0;
+        while (*p >= '0' && *p <= '9' && result <= limit / 10)
+            result = result * 10 + (*p++ - '0');
+        from = (size_t) (p - buffer);
+        if (p == digits || (unsigned char) *p > ' ' || result > limit)
+        {
+            failed = 1;
+            return 0;
+        }
+        return negative ? -result : result;
+    }
+
+    static const size_t lookahead = 64;
+    FILE *f;
+    char buffer[bufferSize + 1];
+    size_t from, to;
+    bool end;
+    // Some integer could not be read, see readInt
+    bool failed;
+};
+
+// Buffered writer of integers and numbers with fixed number of digits after the point
+struct Output
+{
+    Output(FILE *_f) : f(_f), size(0) {}
+    ~Output()
+    {
+        flush();
+    }
+
+    void flush()
+    {
+        fwrite(buffer, 1, size, f);
+        size = 0;
+    }
+
+    // Makes space for number or short string
+    void reserve()
+    {
+        if (size + 64 > bufferSize)
+            flush();
+    }
+
+    void write(char c)
+    {
+        reserve();
+        buffer[size++] = c;
+    }
+
+    void write(const char *s)
+    {
+        reserve();
+        while (*s)
+            buffer[size++] = *s++;
+    }
+
+    void write(long long a)
+    {
+        reserve();
+        writeDigits(a, 1);
+    }
+
+    // Writes a with 6 digits after the point
+    void write(double a)
+    {
+        reserve();
+        if (a < 0)
+        {
+            buffer[size++] = '-';
+            a = -a;
+        }
+        long long scaled = (long long) (a * 1e6 + 0.5);
+        writeDigits(scaled / 1000000, 1);
+        buffer[size++] = '.';
+        writeDigits(scaled % 1000000, 6);
+    }
+
+    // Writes at least minLength digits of a, the space should be reserved
+    void writeDigits(long long a, int minLength)
+    {
+        unsigned long long value = a < 0 ? 0ull - (unsigned long long) a : (unsigned long long) a;
+        if (a < 0)
+            buffer[size++] = '-';
+        char digits[20];
+        int length = 0;
+        while (value || length < minLength)
+        {
+            digits[length++] = (char) ('0' + value % 10);
+            value /= 10;
+        }
+        while (length)
+            buffer[size++] = digits[--length];
+    }
+
+    FILE *f;
+    char buffer[bufferSize];
+    size_t size;
+};
+
+int main(int argc, char **argv)
+{
+    FILE *in = stdin;
+    if (argc > 1 && strcmp(argv[1], "-") != 0 && !(in = fopen(argv[1], "rb")))
+    {
+        fprintf(stderr, "Can not open %s\n", argv[1]);
+        return 1;
+    }
+    // Buffers are too large for stack
+    Input *input = new Input(in);
+    Output *output = new Output(stdout);
+
+    MappedPolygon *mapped = NULL;
+    Polygon *poly;
+    if (argc > 2)
+    {
+        bool ok;
+        mapped = new MappedPolygon(argv[2], &ok);
+        if (!ok)
+        {
+            fprintf(stderr, "Can not read polygon from %s\n", argv[2]);
+            return 1;
+        }
+        poly = new Polygon(mapped->polygon());
+    }
+    else
+    {
+        long long count = input->readInt(1 << 30);
+        if (!input->failed && count < 3)
+        {
+            fprintf(stderr, "Polygon should have at least 3 vertices\n");
+            return 1;
+        }
+        // Vertices are added as they are read, so count that is larger than input
+        // does not allocate memory for it
+        vector <Point> points;
+        for (long long i = 0; i < count && !input->failed; i++)
+        {
+            int x = (int) input->readInt(maxCoordinate);
+            points.push_back(Point(x, (int) input->readInt(maxCoordinate)));
+        }
+        if (input->failed)
+        {
+            fprintf(stderr, "Malformed or truncated polygon\n");
+            return 1;
+        }
+        poly = new Polygon(std::move(points));
+    }
+    // Queries take O(1) expected time with angular index
+    poly->buildAngularIndex();
+
+    char command[16];
+    while (input->readWord(command, sizeof(command)))
+    {
+        if (!strcmp(command, "line"))
+        {
+            int a = (int) input->readInt(maxCoordinate), b = (int) input->readInt(maxCoordinate);
+            Line line(a, b, input->readInt(maxFreeTerm));
+            if (input->failed)
+                break;
+            bool ok;
+            SegmentDouble segment = intersection(line, *poly, &ok);
+            if (!ok)
+                output->write("none");
+            else
+            {
+                output->write(segment.first.x);
+                output->write(' ');
+                output->write(segment.first.y);
+                output->write(' ');
+                output->write(segment.second.x);
+                output->write(' ');
+                output->write(segment.second.y);
+            }
+            output->write('\n');
+            continue;
+        }
+        if (!strcmp(command, "stats"))
+        {
+            output->flush();
+            printStatsJson(stats(), stdout);
+            continue;
+        }
+        Point point;
+        point.x = (int) input->readInt(maxCoordinate);
+        point.y = (int) input->readInt(maxCoordinate);
+        if (input->failed)
+            break;
+        if (!strcmp(command, "inside"))
+            output->write(isInside(point, *poly) ? "1" : "0");
+        else if (!strcmp(command, "dist"))
+            output->write(isInside(point, *poly) ? 0.0 : distance(point, *poly, NULL, NULL));
+        else if (!strcmp(command, "tangent"))
+        {
+            if (isInside(point, *poly))
+                output->write("-1 -1");
+            else
+            {
+                output->write((long long) leftTangent(point, *poly));
+                output->write(' ');
+                output->write((long long) rightTangent(point, *poly));
+            }
+        }
+        else
+        {
+            output->flush();
+            fprintf(stderr, "Unknown query %s\n", command);
+            return 1;
+        }
+        output->write('\n');
+    }
+    if (input->failed)
+    {
+        output->flush();
+        fprintf(stderr, "Malformed or truncated query %s\n", command);
+        return 1;
+    }
+    delete output;
+    delete input;
+    delete poly;
+    delete mapped;
+    if (in != stdin)
+        fclose(in);
+    return 0;
+}
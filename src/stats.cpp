@@ -0,0 +1,149 @@
+#include "stats.h"
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+using namespace std;
+
+#ifdef GEOMETRY_STATS
+
+// Counters of running threads and sum of counters of finished ones
+struct StatsRegistry
+{
+    mutex lock;
+    vector <ThreadStats*> threads;
+    Stats finished;
+};
+
+static StatsRegistry& registry()
+{
+    static StatsRegistry result;
+    return result;
+}
+
+static void addTo(Stats &s, const ThreadStats &t)
+{
+    for (int f = 0; f < STATS_FUNCTION_COUNT; f++)
+    {
+        FunctionStats &function = s.functions[f];
+        function.calls += t.calls[f].load(memory_order_relaxed);
+        function.iterations += t.iterations[f].load(memory_order_relaxed);
+        function.predicates += t.predicates[f].load(memory_order_relaxed);
+        for (int i = 0; i < statsHistogramSize; i++)
+            function.histogram[i] += t.histogram[f][i].load(memory_order_relaxed);
+        for (int e = 0; e < STATS_EVENT_COUNT; e++)
+            function.events[e] += t.events[f][e].load(memory_order_relaxed);
+    }
+    s.predicates += t.totalPredicates.load(memory_order_relaxed);
+}
+
+static void clear(ThreadStats &t)
+{
+    for (int f = 0; f < STATS_FUNCTION_COUNT; f++)
+    {
+        t.calls[f] = t.iterations[f] = t.predicates[f] = 0;
+        for (int i = 0; i < statsHistogramSize; i++)
+            t.histogram[f][i] = 0;
+        for (int e = 0; e < STATS_EVENT_COUNT; e++)
+            t.events[f][e] = 0;
+    }
+    t.totalPredicates = 0;
+}
+
+ThreadStats::ThreadStats()
+{
+    clear(*this);
+    // Registry is created before the first counters, so it is destroyed after them
+    StatsRegistry &r = registry();
+    lock_guard <mutex> guard(r.lock);
+    r.threads.push_back(this);
+}
+
+ThreadStats::~ThreadStats()
+{
+    StatsRegistry &r = registry();
+    lock_guard <mutex> guard(r.lock);
+    addTo(r.finished, *this);
+    for (size_t i = 0; i < r.threads.size(); i++)
+        if (r.threads[i] == this)
+        {
+            r.threads.erase(r.threads.begin() + (long) i);
+            break;
+        }
+}
+
+ThreadStats& threadStats()
+{
+    static thread_local ThreadStats result;
+    return result;
+}
+
+#endif
+
+Stats stats()
+{
+    Stats result;
+    memset(&result, 0, sizeof(result));
+    #ifdef GEOMETRY_STATS
+    StatsRegistry &r = registry();
+    lock_guard <mutex> guard(r.lock);
+    result = r.finished;
+    for (ThreadStats *t : r.threads)
+        addTo(result, *t);
+    #endif
+    return result;
+}
+
+void resetStats()
+{
+    #ifdef GEOMETRY_STATS
+    StatsRegistry &r = registry();
+    lock_guard <mutex> guard(r.lock);
+    memset(&r.finished, 0, sizeof(r.finished));
+    // Other threads may be counting now, so their counters are reset only approximately
+    for (ThreadStats *t : r.threads)
+        clear(*t);
+    #endif
+}
+
+const char* statsFunctionName(StatsFunction function)
+{
+    static const char *names[STATS_FUNCTION_COUNT] = {"isInside", "isInsideBS2", "leftTangent",
+        "rightTangent", "distance", "maximalPoint", "intersection"};
+    return names[function];
+}
+
+const char* statsEventName(StatsEvent event)
+{
+    static const char *names[STATS_EVENT_COUNT] = {"angularIndex", "collinearSkip", "earlyExit", "outsideBounds"};
+    return names[event];
+}
+
+void printStatsJson(const Stats &s, FILE *f)
+{
+    fprintf(f, "{\"predicates\": %llu, \"functions\": {", s.predicates);
+    bool first = 1;
+    for (int i = 0; i < STATS_FUNCTION_COUNT; i++)
+    {
+        const FunctionStats &function = s.functions[i];
+        if (!function.calls)
+            continue;
+        fprintf(f, "%s\"%s\": {\"calls\": %llu, \"iterations\": %llu, \"predicates\": %llu, \"histogram\": {",
+                first ? "" : ", ", statsFunctionName((StatsFunction) i), function.calls,
+                function.iterations, function.predicates);
+        first = 0;
+        bool firstBucket = 1;
+        for (int j = 0; j < statsHistogramSize; j++)
+            if (function.histogram[j])
+            {
+                fprintf(f, "%s\"%d\": %llu", firstBucket ? "" : ", ", j, function.histogram[j]);
+                firstBucket = 0;
+            }
+        fprintf(f, "}, \"events\": {");
+        for (int j = 0; j < STATS_EVENT_COUNT; j++)
+            fprintf(f, "%s\"%s\": %llu", j ? ", " : "", statsEventName((StatsEvent) j), function.events[j]);
+        fprintf(f, "}, \"outsideBoundsRate\": %.6f}",
+                (double) function.events[STATS_OUTSIDE_BOUNDS] / (double) function.calls);
+    }
+    fprintf(f, "}}\n");
+}
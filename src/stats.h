@@ -0,0 +1,152 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <cassert>
+#include <cstdio>
+#ifdef GEOMETRY_STATS
+#include <atomic>
+#endif
+
+// Counters of work done by queries to polygon. They are collected only if program
+// is compiled with -DGEOMETRY_STATS, otherwise they cost nothing and stats() is zero.
+// Every thread counts into its own counters, stats() sums them over all threads
+
+enum StatsFunction
+{
+    STATS_IS_INSIDE,
+    STATS_IS_INSIDE_BS2,
+    STATS_LEFT_TANGENT,
+    STATS_RIGHT_TANGENT,
+    STATS_DISTANCE,
+    STATS_MAXIMAL_POINT,
+    STATS_INTERSECTION,
+    STATS_FUNCTION_COUNT
+};
+
+enum StatsEvent
+{
+    // Query was answered or narrowed with angular index
+    STATS_ANGULAR_INDEX,
+    // Binary search stepped over one side that is collinear with point or
+    // perpendicular to direction (l++ in tangents and maximalPoint)
+    STATS_COLLINEAR_SKIP,
+    // Binary search stopped before its range shrank to one side
+    STATS_EARLY_EXIT,
+    // Point or line is outside bounds of polygon (see Bounds in geometry.h), so query
+    // was rejected in O(1)
+    STATS_OUTSIDE_BOUNDS,
+    STATS_EVENT_COUNT
+};
+
+const int statsHistogramSize = 64;
+
+struct FunctionStats
+{
+    unsigned long long calls;
+    // Iterations of binary searches and evaluations of % and * of points
+    // (with nested calls of other functions)
+    unsigned long long iterations, predicates;
+    // histogram[i] is the number of calls that made i iterations, the last one
+    // counts calls that made more
+    unsigned long long histogram[statsHistogramSize];
+    unsigned long long events[STATS_EVENT_COUNT];
+};
+
+struct Stats
+{
+    FunctionStats functions[STATS_FUNCTION_COUNT];
+    // All evaluations of % and * of points, also outside of counted functions
+    unsigned long long predicates;
+};
+
+// Sum of counters of all threads, including ones that have finished
+Stats stats();
+void resetStats();
+const char* statsFunctionName(StatsFunction function);
+const char* statsEventName(StatsEvent event);
+// Writes stats in one line as JSON object. Only called functions are written
+// and only non-zero elements of histograms
+void printStatsJson(const Stats &s, FILE *f = stdout);
+
+#ifdef GEOMETRY_STATS
+// Counters of one thread. Only the owner thread changes them, so atomics are
+// only needed to read them from other threads and increments are not locked
+struct ThreadStats
+{
+    typedef std::atomic <unsigned long long> Counter;
+
+    ThreadStats();
+    ~ThreadStats();
+    static void add(Counter &counter, unsigned long long value)
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+
+    Counter calls[STATS_FUNCTION_COUNT];
+    Counter iterations[STATS_FUNCTION_COUNT];
+    Counter predicates[STATS_FUNCTION_COUNT];
+    Counter histogram[STATS_FUNCTION_COUNT][statsHistogramSize];
+    Counter events[STATS_FUNCTION_COUNT][STATS_EVENT_COUNT];
+    Counter totalPredicates;
+};
+
+ThreadStats& threadStats();
+#endif
+
+inline void countPredicate()
+{
+    #ifdef GEOMETRY_STATS
+    ThreadStats::add(threadStats().totalPredicates, 1);
+    #endif
+}
+
+// Counts one call of function and iterations of its binary search. In debug build
+// it also checks that search makes at most log2(size) + slack + 1 iterations
+struct StatsScope
+{
+    StatsScope(StatsFunction _function, long long _size, int _slack) :
+        function(_function), size(_size), slack(_slack), iterations(0)
+    {
+        #ifdef GEOMETRY_STATS
+        predicatesBefore = threadStats().totalPredicates.load(std::memory_order_relaxed);
+        #endif
+    }
+
+    ~StatsScope()
+    {
+        #ifdef GEOMETRY_STATS
+        ThreadStats &s = threadStats();
+        ThreadStats::add(s.calls[function], 1);
+        ThreadStats::add(s.iterations[function], (unsigned long long) iterations);
+        ThreadStats::add(s.predicates[function],
+                         s.totalPredicates.load(std::memory_order_relaxed) - predicatesBefore);
+        ThreadStats::add(s.histogram[function][iterations < statsHistogramSize ? iterations : statsHistogramSize - 1], 1);
+        #endif
+    }
+
+    void iteration()
+    {
+        iterations++;
+        #ifdef DEBUG
+        assert(iterations <= slack || (iterations - slack - 1 < 62 && (1ll << (iterations - slack - 1)) <= size));
+        #endif
+    }
+
+    void event(StatsEvent e)
+    {
+        #ifdef GEOMETRY_STATS
+        ThreadStats::add(threadStats().events[function][e], 1);
+        #else
+        (void) e;
+        #endif
+    }
+
+    StatsFunction function;
+    long long size;
+    int slack, iterations;
+    #ifdef GEOMETRY_STATS
+    unsigned long long predicatesBefore;
+    #endif
+};
+
+#endif
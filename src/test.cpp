@@ -1,8 +1,20 @@
 #include "geometry.h"
+#include "executor.h"
+#include "polygonset.h"
+#include "basicgeometry.h"
+#include "polygonfile.h"
+#include "stats.h"
 #include <cassert>
+#include <atomic>
 #include <iostream>
 #include <algorithm>
+#include <cmath>
+#include <mutex>
+#include <random>
+#include <cstddef>
+#include <cstring>
 #include <ctime>
+#include <thread>
 #include <tuple>
 
 using namespace std;
@@ -91,7 +103,9 @@ make_tuple(Line(Point(-1, -3), Point(3, -1)), octagon, SegmentDouble(PointDouble
 make_tuple(Line(Point(MAX, MAX), Point(-MAX, -MAX)), maxSquare, SegmentDouble(PointDouble(MAX, MAX), PointDouble(-MAX, -MAX)))
 };
 
-Polygon genLargePolygon(int maxSideCoord)
+// Polygon with sides that are all primitive vectors with coordinates up to maxSideCoord,
+// so it has many vertices with small coordinates. It starts from vertex start
+Polygon genLatticePolygon(int maxSideCoord, const Point &start)
 {
     vector <Point> points;
     for (int i = 1; i <= maxSideCoord; i++)
@@ -108,7 +122,7 @@ Polygon genLargePolygon(int maxSideCoord)
     points.push_back(Point(maxSideCoord, 0));
     points.push_back(Point(-maxSideCoord, 0));
     sort(points.begin(), points.end(), compareByAngle);
-    points[0] = Point(rand() - RAND_MAX / 2, rand() - RAND_MAX / 2);
+    points[0] = start;
     for (int i = 1; i < (int) points.size(); i++)
         points[i] += points[i - 1];
     return Polygon(points);                                
@@ -121,9 +135,43 @@ int rand31()
     return (rand() << 16) + rand();
 }
 
+// Absolute error for small numbers and relative one for large numbers,
+// as doubles near 2^30 are not more precise than 1e-7
 bool eq(double a, double b)
 {
-    return abs(a - b) < 1e-8;   
+    return abs(a - b) < 1e-8 * max(1.0, abs(b));   
+}
+
+#ifndef GEOMETRY_STATS
+constexpr Point constexprSquare[] = {Point(0, 0), Point(2, 0), Point(2, 2), Point(0, 2)};
+static_assert(isStrictlyConvex(constexprSquare, 4), "square is convex");
+static_assert(orientation(Point(0, 0), Point(1, 1), Point(2, 2)) == 0 && Line(Point(0, 0), Point(2, 2)).side(Point(0, 1)) < 0,
+              "point is to the left of the line");
+#endif
+
+void testPredicates()
+{
+    Point square[] = {Point(0, 0), Point(2, 0), Point(2, 2), Point(0, 2)};
+    assert(isStrictlyConvex(square, 4));
+    swap(square[1], square[3]);
+    assert(!isStrictlyConvex(square, 4));
+    // Pentagram turns left at every vertex, but goes around twice
+    Point star[] = {Point(0, 10), Point(-6, -8), Point(10, 3), Point(-10, 3), Point(6, -8)};
+    for (int i = 0; i < 5; i++)
+        assert(orientation(star[i], star[(i + 1) % 5], star[(i + 2) % 5]) > 0);
+    assert(!isStrictlyConvex(star, 5));
+    Point collinear[] = {Point(0, 0), Point(1, 0), Point(2, 0), Point(1, 1)};
+    assert(!isStrictlyConvex(collinear, 4) && !isStrictlyConvex(collinear, 2));
+    for (auto &poly : handPolygons)
+        assert(isStrictlyConvex(poly.data(), poly.size()));
+    for (int i = 0; i < 1000; i++)
+    {
+        Point a(rand() % 2001 - 1000, rand() % 2001 - 1000), b(rand() % 2001 - 1000, rand() % 2001 - 1000);
+        Point c(rand() % 2001 - 1000, rand() % 2001 - 1000);
+        assert(orientation(a, b, c) == -orientation(b, a, c) && orientation(a, b, c) == orientation(b, c, a));
+        if (a != b)
+            assert(Line(a, b).side(c) == -orientation(a, b, c) && Line(a, b).side(a) == 0);
+    }
 }
 
 void testIsInside()
@@ -137,12 +185,12 @@ void testIsInside()
     assert(!isInsideLinear(Point(10, 1), a));
     assert(!isInsideLinear(Point(3, -1), a));
 
-    assert(isInsideBS1(Point(0, 0), a));
-    assert(isInsideBS1(Point(1, 1), a));
-    assert(isInsideBS1(Point(1, 2), a));
-    assert(!isInsideBS1(Point(-1, 2), a));
-    assert(!isInsideBS1(Point(10, 1), a));
-    assert(!isInsideBS1(Point(3, -1), a));
+    assert(isInside(Point(0, 0), a));
+    assert(isInside(Point(1, 1), a));
+    assert(isInside(Point(1, 2), a));
+    assert(!isInside(Point(-1, 2), a));
+    assert(!isInside(Point(10, 1), a));
+    assert(!isInside(Point(3, -1), a));
 
     assert(isInsideBS2(Point(0, 0), a));
     assert(isInsideBS2(Point(1, 1), a));
@@ -154,7 +202,7 @@ void testIsInside()
     for (auto &test : isInsideTests)
     {
         assert(isInsideLinear(get<0>(test), get<1>(test)) == get<2>(test));
-        assert(isInsideBS1(get<0>(test), get<1>(test)) == get<2>(test));
+        assert(isInside(get<0>(test), get<1>(test)) == get<2>(test));
         assert(isInsideBS2(get<0>(test), get<1>(test)) == get<2>(test)); 
     }
     for (auto &poly : handPolygons)
@@ -162,13 +210,787 @@ void testIsInside()
         for (int i = 0; i < poly.size(); i++)
         {
             assert(isInsideLinear(poly[i], poly));
-            assert(isInsideBS1(poly[i], poly));
+            assert(isInside(poly[i], poly));
             assert(isInsideBS2(poly[i], poly)); 
         }
     }
                
 }
 
+// Checks that some side of first has all vertices of second strictly to the right
+bool isSeparatedBySide(const Polygon &first, const Polygon &second)
+{
+    for (int i = 0; i < first.size(); i++)
+    {
+        bool separated = 1;
+        for (int j = 0; j < second.size() && separated; j++)
+            separated = (first[i + 1] - first[i]) % (second[j] - first[i]) < 0;
+        if (separated)
+            return 1;
+    }
+    return 0;
+}
+
+Polygon genSmallPolygon(int range)
+{
+    vector <Point> points(rand() % 8 + 3);
+    for (auto &p : points)
+        p = Point(rand() % (2 * range + 1) - range, rand() % (2 * range + 1) - range);
+    bool ok;
+    Polygon result = convexHull(points, &ok);
+    return ok ? result : genSmallPolygon(range);
+}
+
+void testIsInsideBatch()
+{
+    for (auto &poly : handPolygons)
+    {
+        vector <Point> points;
+        for (int i = -7; i <= 7; i++)
+            for (int j = -7; j <= 7; j++)
+                points.push_back(Point(i, j));
+        for (int i = 0; i < poly.size(); i++)
+            points.push_back(poly[i]);
+        vector <char> result(points.size());
+        isInsideBatch(points.data(), (int) points.size(), poly, (bool *) result.data());
+        for (int i = 0; i < (int) points.size(); i++)
+            assert(isInsideLinear(points[i], poly) == (bool) result[i]);
+        isInsideSorted(points.data(), (int) points.size(), poly, (bool *) result.data());
+        for (int i = 0; i < (int) points.size(); i++)
+            assert(isInside(points[i], poly) == (bool) result[i]);
+    }
+    for (int test = 0; test < 100; test++)
+    {
+        Polygon poly = test % 2 ? genSmallPolygon(5) : genLargePolygon(rand() % 100 + 3, 1000);
+        vector <Point> points;
+        for (int i = 0; i < 1000; i++)
+            points.push_back(Point(rand() % 2001 - 1000, rand() % 2001 - 1000));
+        for (int i = 0; i < poly.size(); i++)
+            points.push_back(poly[i] + Point(rand() % 3 - 1, rand() % 3 - 1));
+        vector <char> result(points.size());
+        isInsideSorted(points.data(), (int) points.size(), poly, (bool *) result.data());
+        for (int i = 0; i < (int) points.size(); i++)
+            assert(isInside(points[i], poly) == (bool) result[i]);
+    }
+    for (auto &test : isInsideTests)
+    {
+        bool result;
+        isInsideBatch(&get<0>(test), 1, get<1>(test), &result);
+        assert(result == get<2>(test));
+    }
+}
+
+void testAngularIndex()
+{
+    for (auto poly : handPolygons)
+    {
+        poly.buildAngularIndex();
+        for (int i = -10; i <= 10; i++)
+            for (int j = -10; j <= 10; j++)
+            {
+                Point pnt(i, j);
+                bool inside = isInsideLinear(pnt, poly);
+                assert(isInside(pnt, poly) == inside);
+                if (pnt != Point(0, 0))
+                    assert(poly[maximalPoint(pnt, poly)] * pnt == poly[maximalPointLinear(pnt, poly)] * pnt);
+                if (!inside)
+                {
+                    assert(poly[leftTangent(pnt, poly)] == poly[leftTangentLinear(pnt, poly)]);
+                    assert(poly[rightTangent(pnt, poly)] == poly[rightTangentLinear(pnt, poly)]);
+                }
+            }
+    }
+}
+
+void testSoA()
+{
+    for (auto poly : handPolygons)
+    {
+        Polygon soa = poly;
+        soa.buildSoA();
+        for (int i = -10; i <= 10; i++)
+            for (int j = -10; j <= 10; j++)
+            {
+                Point pnt(i, j);
+                bool inside = isInsideLinear(pnt, poly);
+                assert(isInsideLinear(pnt, soa) == inside);
+                assert(isInsideBS2(pnt, soa) == inside);
+                assert(maximalPointLinear(pnt, soa) == maximalPointLinear(pnt, poly));
+                assert(minimalPointLinear(pnt, soa) == minimalPointLinear(pnt, poly));
+                if (!inside)
+                    assert(eq(distanceLinear(pnt, soa), distanceLinear(pnt, poly)));
+                if (pnt != poly[0])
+                {
+                    bool ok1, ok2;
+                    SegmentDouble result = intersectionLinear(Line(poly[0], pnt), soa, &ok1);
+                    assert(result == intersectionLinear(Line(poly[0], pnt), poly, &ok2) && ok1 == ok2);
+                }
+            }
+    }
+}
+
+void testGenLargePolygon()
+{
+    for (int vcnt : {3, 4, 5, 10, 1000, 100000})
+        for (unsigned long long seed = 1; seed <= 3; seed++)
+        {
+            Polygon poly = genLargePolygon(vcnt, 1e9, seed);
+            assert(poly.size() == vcnt);
+            for (int i = 0; i < vcnt; i++)
+            {
+                assert((poly[i + 1] - poly[i]) % (poly[i + 2] - poly[i + 1]) > 0);
+                assert(abs(poly[i].x) < (1<<30) && abs(poly[i].y) < (1<<30));
+            }
+            Polygon same = genLargePolygon(vcnt, 1e9, seed);
+            for (int i = 0; i < vcnt; i++)
+                assert(poly[i] == same[i]);
+        }
+    // Radius is too small for so many vertices, so it is increased
+    for (int vcnt : {3, 50, 1000})
+        for (double radius : {1.0, 10.0, 100.0})
+        {
+            Polygon poly = genLargePolygon(vcnt, radius, 7);
+            assert(poly.size() == vcnt);
+            for (int i = 0; i < vcnt; i++)
+                assert((poly[i + 1] - poly[i]) % (poly[i + 2] - poly[i + 1]) > 0);
+        }
+}
+
+void testConvexHull()
+{
+    Executor executor(4);
+    for (int range : {1, 2, 10, 1000, 1<<30})
+        for (int test = 0; test < 20; test++)
+        {
+            vector <Point> points(rand() % 5000 + 1);
+            for (auto &p : points)
+                p = Point(rand31() % (2 * range - 1) - range + 1, rand31() % (2 * range - 1) - range + 1);
+            bool ok;
+            Polygon hull = convexHull(points, &ok);
+            assert(ok == (hull.size() >= 3));
+            Polygon parallel = executor.convexHull(points.data(), (int) points.size(), &ok);
+            assert(parallel.size() == hull.size() && ok == (hull.size() >= 3));
+            for (int i = 0; i < hull.size(); i++)
+            {
+                assert(parallel[i] == hull[i]);
+                assert(find(points.begin(), points.end(), hull[i]) != points.end());
+                if (ok)
+                    assert((hull[i + 1] - hull[i]) % (hull[i + 2] - hull[i + 1]) > 0);
+            }
+            if (ok)
+                for (auto &p : points)
+                    assert(isInsideLinear(p, hull));
+        }
+    // Repeated vertices of convex polygon in random order
+    Polygon poly = genLargePolygon(1000, 1e6, 1);
+    vector <Point> points(poly.data(), poly.data() + poly.size());
+    points.insert(points.end(), poly.data(), poly.data() + poly.size());
+    random_shuffle(points.begin(), points.end());
+    Polygon hull = convexHull(points);
+    assert(hull.size() == poly.size() && isInsideLinear(hull[0], poly));
+    // Lattice points of square, many of them are on its sides
+    points.clear();
+    for (int i = 0; i <= 10; i++)
+        for (int j = 0; j <= 10; j++)
+            points.push_back(Point(i, j));
+    hull = convexHull(points);
+    assert(hull.size() == 4 && hull[0] == Point(0, 0) && hull[1] == Point(10, 0) && hull[2] == Point(10, 10));
+}
+
+void testPolygonIntersection()
+{
+    // Small coordinates, so polygons often touch by vertices and sides
+    for (int test = 0; test < 20000; test++)
+    {
+        Polygon first = genSmallPolygon(3), second = genSmallPolygon(3);
+        if (test % 2)
+            second.buildAngularIndex();
+        bool expected = !isSeparatedBySide(first, second) && !isSeparatedBySide(second, first);
+        assert(isIntersection(first, second) == expected);
+        vector <PointDouble> result = intersection(first, second);
+        assert(expected || result.empty());
+        for (auto &p : result)
+            for (auto poly : {&first, &second})
+                for (int i = 0; i < poly->size(); i++)
+                {
+                    Point side = (*poly)[i + 1] - (*poly)[i];
+                    assert(side.x * (p.y - (*poly)[i].y) - side.y * (p.x - (*poly)[i].x) > -1e-6);
+                }
+        // Vertices of first that are strictly inside second are vertices of intersection
+        for (int i = 0; i < first.size(); i++)
+        {
+            bool inside = 1;
+            for (int j = 0; j < second.size(); j++)
+                inside &= (second[j + 1] - second[j]) % (first[i] - second[j]) > 0;
+            if (inside)
+                assert(find(result.begin(), result.end(), PointDouble(first[i])) != result.end());
+        }
+    }
+    Polygon square({Point(0, 0), Point(2, 0), Point(2, 2), Point(0, 2)});
+    Polygon shifted({Point(1, 1), Point(3, 1), Point(3, 3), Point(1, 3)});
+    vector <PointDouble> result = intersection(square, shifted);
+    assert(result.size() == 4 && find(result.begin(), result.end(), PointDouble(1, 1)) != result.end() &&
+           find(result.begin(), result.end(), PointDouble(2, 2)) != result.end());
+    Polygon far({Point(3, 0), Point(4, 0), Point(3, 1)});
+    assert(!isIntersection(square, far) && intersection(square, far).empty());
+}
+
+void testMinkowski()
+{
+    for (int test = 0; test < 20000; test++)
+    {
+        Polygon first = genSmallPolygon(3), second = genSmallPolygon(3);
+        vector <Point> sums, differences;
+        for (int i = 0; i < first.size(); i++)
+            for (int j = 0; j < second.size(); j++)
+            {
+                sums.push_back(first[i] + second[j]);
+                differences.push_back(second[j] - first[i]);
+            }
+        Polygon sum = minkowskiSum(first, second), hull = convexHull(sums);
+        assert(sum.size() == hull.size());
+        for (int i = 0; i < hull.size(); i++)
+            assert(find(sums.begin(), sums.end(), sum[i]) != sums.end() && (sum[i + 1] - sum[i]) % (sum[i + 2] - sum[i + 1]) > 0);
+
+        Point shift(rand() % 9 - 4, rand() % 9 - 4), dir;
+        while (dir == Point(0, 0))
+            dir = Point(rand() % 7 - 3, rand() % 7 - 3);
+        vector <Point> moved;
+        for (int i = 0; i < first.size(); i++)
+            moved.push_back(first[i] + shift);
+        Polygon shifted(moved);
+        assert(isCollision(first, shift, second) == isIntersection(shifted, second));
+        // shift + t * dir lies to the left of side i of difference iff a + b * t >= 0
+        Polygon difference = convexHull(differences);
+        bool inside = 1;
+        double expected = 1e18;
+        for (int i = 0; i < difference.size(); i++)
+        {
+            Point side = difference[i + 1] - difference[i];
+            long long a = side % (shift - difference[i]), b = side % dir;
+            inside &= a > 0;
+            if (b < 0)
+                expected = min(expected, (double) a / (double) -b);
+        }
+        expected = inside ? expected * dir.len() : 0;
+        assert(fabs(penetrationDepth(first, shift, second, dir) - expected) < 1e-6);
+    }
+    Polygon square({Point(0, 0), Point(2, 0), Point(2, 2), Point(0, 2)});
+    Polygon doubled = minkowskiSum(square, square);
+    assert(doubled.size() == 4 && doubled[doubled.upmost] == Point(4, 4) && doubled[doubled.downmost] == Point(4, 0));
+    assert(isCollision(square, Point(2, 2), square) && !isCollision(square, Point(3, 0), square));
+    assert(fabs(penetrationDepth(square, Point(1, 0), square, Point(1, 0)) - 1) < 1e-9);
+    assert(fabs(penetrationDepth(square, Point(1, 0), square, Point(-3, 0)) - 3) < 1e-9);
+    assert(penetrationDepth(square, Point(2, 0), square, Point(1, 0)) == 0);
+}
+
+void testPolygonDistance()
+{
+    for (int test = 0; test < 20000; test++)
+    {
+        Polygon first = genSmallPolygon(3), second = genSmallPolygon(3);
+        vector <Point> moved;
+        Point shift(rand() % 13 - 6, rand() % 13 - 6);
+        for (int i = 0; i < second.size(); i++)
+            moved.push_back(second[i] + shift);
+        second = Polygon(moved);
+        bool intersect = isIntersection(first, second), ok;
+        double expected = 1e18;
+        for (int i = 0; i < first.size(); i++)
+            for (int j = 0; j < second.size(); j++)
+                expected = min(expected, min(distance(first[i], Segment(second[j], second[j + 1])),
+                                             distance(second[j], Segment(first[i], first[i + 1]))));
+        PointDouble firstNearest, secondNearest;
+        double result = distance(first, second, &firstNearest, &secondNearest);
+        Line line = separatingLine(first, second, &ok);
+        assert(ok == !intersect);
+        if (intersect)
+        {
+            assert(result == 0);
+            continue;
+        }
+        assert(fabs(result - expected) < 1e-6);
+        assert(fabs(hypot(firstNearest.x - secondNearest.x, firstNearest.y - secondNearest.y) - result) < 1e-6);
+        for (auto poly : {&first, &second})
+        {
+            PointDouble p = poly == &first ? firstNearest : secondNearest;
+            for (int i = 0; i < poly->size(); i++)
+            {
+                Point side = (*poly)[i + 1] - (*poly)[i];
+                assert(side.x * (p.y - (*poly)[i].y) - side.y * (p.x - (*poly)[i].x) > -1e-6);
+            }
+        }
+        for (int i = 0; i < first.size(); i++)
+            assert(line.a * first[i].x + line.b * first[i].y + line.c < 0);
+        for (int i = 0; i < second.size(); i++)
+            assert(line.a * second[i].x + line.b * second[i].y + line.c >= 0);
+    }
+    Polygon square({Point(0, 0), Point(2, 0), Point(2, 2), Point(0, 2)});
+    Polygon far({Point(5, 6), Point(6, 6), Point(5, 7)});
+    PointDouble firstNearest, secondNearest;
+    assert(fabs(distance(square, far, &firstNearest, &secondNearest) - 5) < 1e-9);
+    assert(firstNearest == PointDouble(2, 2) && secondNearest == PointDouble(5, 6));
+}
+
+void testBasicGeometry()
+{
+    for (int test = 0; test < 300; test++)
+    {
+        Polygon poly = genLargePolygon(rand() % 50 + 3, 1 << 13);
+        vector <Point16> points16;
+        vector <Point64> points64;
+        // Large coordinates are the same up to scale
+        const int64_t scale = 1ll << 32;
+        for (int i = 0; i < poly.size(); i++)
+        {
+            points16.push_back(Point16((int16_t) poly[i].x, (int16_t) poly[i].y));
+            points64.push_back(Point64(poly[i].x * scale, poly[i].y * scale));
+        }
+        Polygon16 poly16(points16);
+        Polygon64 poly64(points64);
+        assert(poly16.upmost == poly.upmost && poly64.downmost == poly.downmost);
+        for (int i = 0; i < 100; i++)
+        {
+            Point point(rand() % (1 << 15) - (1 << 14), rand() % (1 << 15) - (1 << 14));
+            Point16 point16((int16_t) point.x, (int16_t) point.y);
+            Point64 point64(point.x * scale, point.y * scale);
+            bool inside = isInside(point, poly);
+            assert(isInside(point16, poly16) == inside && isInsideHalfPlanes(point16, poly16) == inside);
+            assert(isInside(point64, poly64) == inside && isInsideHalfPlanes(point64, poly64) == inside);
+            if (!inside)
+            {
+                assert(leftTangent(point16, poly16) == leftTangent(point, poly));
+                assert(rightTangent(point64, poly64) == rightTangent(point, poly));
+            }
+            if (point != Point(0, 0))
+            {
+                assert(maximalPoint(point16, poly16) == maximalPoint(point, poly));
+                assert(minimalPoint(point64, poly64) == minimalPoint(point, poly));
+            }
+        }
+    }
+}
+
+// Flips the lowest bit of byte at offset in file
+void flipByte(const char *path, size_t offset)
+{
+    FILE *f = fopen(path, "r+b");
+    assert(f);
+    fseek(f, (long) offset, SEEK_SET);
+    int c = fgetc(f);
+    // Switching from reading to writing needs a seek
+    fseek(f, (long) offset, SEEK_SET);
+    fputc(c ^ 1, f);
+    fclose(f);
+}
+
+void testPolygonFile()
+{
+    const char *path = "polygon.bin";
+    Polygon poly = genLargePolygon(1000, 1 << 20);
+    assert(savePolygon(path, poly));
+    {
+        bool ok;
+        MappedPolygon mapped(path, &ok);
+        assert(ok);
+        const Polygon &view = mapped.polygon();
+        assert(view.size() == poly.size() && view.upmost == poly.upmost && view.downmost == poly.downmost);
+        assert(mapped.header().minY == poly[poly.downmost].y && mapped.header().maxY == poly[poly.upmost].y);
+        for (int i = 0; i < 1000; i++)
+        {
+            Point point(rand() % (1 << 22) - (1 << 21), rand() % (1 << 22) - (1 << 21));
+            assert(isInside(point, view) == isInside(point, poly));
+            assert(maximalPoint(point, view) == maximalPoint(point, poly));
+        }
+        // Copy of polygon refers to the same vertices
+        Polygon copy = view;
+        assert(copy.data() == view.data());
+    }
+    bool ok;
+    // Changed upmost vertex or bounding box in header is found by verification
+    flipByte(path, offsetof(PolygonFileHeader, upmost));
+    MappedPolygon wrongUpmost(path, &ok);
+    assert(!ok);
+    flipByte(path, offsetof(PolygonFileHeader, upmost));
+    flipByte(path, offsetof(PolygonFileHeader, maxX));
+    MappedPolygon wrongBox(path, &ok);
+    assert(!ok);
+    flipByte(path, offsetof(PolygonFileHeader, maxX));
+    MappedPolygon restored(path, &ok);
+    assert(ok);
+    // Changed vertex breaks checksum
+    flipByte(path, sizeof(PolygonFileHeader));
+    MappedPolygon broken(path, &ok);
+    assert(!ok);
+    MappedPolygon unchecked(path, &ok, 0);
+    assert(ok);
+    remove(path);
+    MappedPolygon missing(path, &ok);
+    assert(!ok);
+}
+
+void testHints()
+{
+    for (int test = 0; test < 200; test++)
+    {
+        Polygon poly = test % 2 ? genSmallPolygon(5) : genLargePolygon(rand() % 1000 + 3, 1 << 20);
+        int range = test % 2 ? 8 : 1 << 21, hint = 0;
+        for (int i = 0; i < 500; i++)
+        {
+            Point point(rand() % (2 * range + 1) - range, rand() % (2 * range + 1) - range);
+            int random = rand() % poly.size();
+            bool inside = isInside(point, poly);
+            assert(isInside(point, poly, hint) == inside && isInside(point, poly, random) == inside);
+            if (!inside)
+            {
+                assert(leftTangent(point, poly, rand() % poly.size()) == leftTangent(point, poly));
+                assert(rightTangent(point, poly, rand() % poly.size()) == rightTangent(point, poly));
+            }
+            if (point != Point(0, 0))
+            {
+                assert(poly[maximalPoint(point, poly, random)] * point == poly[maximalPoint(point, poly)] * point);
+                assert(poly[minimalPoint(point, poly, random)] * point == poly[minimalPoint(point, poly)] * point);
+            }
+        }
+    }
+    // Point that moves around polygon, hints are previous answers
+    Polygon poly = genLargePolygon(100000, 1 << 28);
+    int left = 0, right = 0, top = 0;
+    for (int i = 0; i < 10000; i++)
+    {
+        double angle = 2 * M_PI * i / 10000;
+        Point point((int) (1e9 * cos(angle)), (int) (1e9 * sin(angle)));
+        left = leftTangent(point, poly, left);
+        right = rightTangent(point, poly, right);
+        top = maximalPoint(point, poly, top);
+        assert(left == leftTangent(point, poly) && right == rightTangent(point, poly));
+        assert(poly[top] * point == poly[maximalPoint(point, poly)] * point);
+    }
+}
+
+void testRotatingCalipers()
+{
+    for (int test = 0; test < 2000; test++)
+    {
+        Polygon poly = test % 2 ? genSmallPolygon(10) : genLargePolygon(rand() % 100 + 3, 1 << 20);
+        int n = poly.size();
+        // Antipodal pairs are ends of supporting lines orthogonal to normals of sides
+        vector <pair <int, int> > expected, pairs;
+        long long diameter2 = 0;
+        long double minWidth = 1e30, minArea = 1e30, minPerimeter = 1e30;
+        for (int i = 0; i < n; i++)
+        {
+            Point side = poly[i + 1] - poly[i], normal(side.y, -side.x);
+            long long low = poly[minimalPointLinear(normal, poly)] * normal;
+            long long from = poly[minimalPointLinear(side, poly)] * side, to = poly[maximalPointLinear(side, poly)] * side;
+            for (int j = 0; j < n; j++)
+                if (poly[j] * normal == low)
+                {
+                    expected.push_back(make_pair(min(i, j), max(i, j)));
+                    expected.push_back(make_pair(min((i + 1) % n, j), max((i + 1) % n, j)));
+                }
+            long double len = sqrtl((long double) side.len2()), height = (long double) (poly[i] * normal - low) / len;
+            minWidth = min(minWidth, height);
+            minArea = min(minArea, height * (long double) (to - from) / len);
+            minPerimeter = min(minPerimeter, 2 * (height + (long double) (to - from) / len));
+            for (int j = 0; j < n; j++)
+                diameter2 = max(diameter2, (poly[i] - poly[j]).len2());
+        }
+        sort(expected.begin(), expected.end());
+        expected.erase(unique(expected.begin(), expected.end()), expected.end());
+        antipodalPairs(poly, pairs);
+        assert(pairs == expected);
+
+        int first, second, side, vertex;
+        assert(fabs(diameter(poly, &first, &second) - sqrt((double) diameter2)) < 1e-6);
+        assert((poly[first] - poly[second]).len2() == diameter2);
+        assert(fabs(width(poly, &side, &vertex) - minWidth) < 1e-6 * (1 + minWidth));
+        Point dir = poly[side + 1] - poly[side];
+        assert(fabs((long double) (dir % (poly[vertex] - poly[side])) / dir.len() - minWidth) < 1e-6 * (1 + minWidth));
+        for (int kind = 0; kind < 2; kind++)
+        {
+            vector <PointDouble> rect = kind ? minPerimeterRectangle(poly) : minAreaRectangle(poly);
+            assert(rect.size() == 4);
+            double a = hypot(rect[1].x - rect[0].x, rect[1].y - rect[0].y), b = hypot(rect[2].x - rect[1].x, rect[2].y - rect[1].y);
+            long double best = kind ? minPerimeter : minArea, current = kind ? 2 * (a + b) : a * b;
+            assert(fabs(current - best) < 1e-6 * (1 + best));
+            // Polygon lies inside the rectangle
+            for (int j = 0; j < 4; j++)
+                for (int i = 0; i < n; i++)
+                {
+                    double dx = rect[(j + 1) % 4].x - rect[j].x, dy = rect[(j + 1) % 4].y - rect[j].y;
+                    assert(dx * (poly[i].y - rect[j].y) - dy * (poly[i].x - rect[j].x) > -1e-6 * (1 + dx * dx + dy * dy));
+                }
+        }
+    }
+    Polygon square({Point(0, 0), Point(2, 0), Point(2, 2), Point(0, 2)});
+    vector <pair <int, int> > pairs;
+    antipodalPairs(square, pairs);
+    assert(pairs.size() == 6 && fabs(width(square) - 2) < 1e-9 && fabs(diameter(square) - sqrt(8.0)) < 1e-9);
+}
+
+void testPolygonView()
+{
+    Polygon poly = genLargePolygon(1000, 1 << 20);
+    // Vertices are in a buffer owned by caller
+    vector <Point> buffer(poly.data(), poly.data() + poly.size());
+    bool ok;
+    PolygonView view(buffer.data(), (int) buffer.size(), &ok);
+    assert(ok && view.upmost == poly.upmost && view.downmost == poly.downmost);
+    assert(Polygon(view).data() == buffer.data());
+    // Bounds are found once with view and copied by conversion to polygon
+    Polygon converted = view;
+    assert(!memcmp(&view.bounds, &poly.bounds, sizeof(Bounds)) && !memcmp(&converted.bounds, &view.bounds, sizeof(Bounds)));
+    for (int i = 0; i < 1000; i++)
+    {
+        Point point(rand() % (1 << 22) - (1 << 21), rand() % (1 << 22) - (1 << 21));
+        assert(isInside(point, view) == isInside(point, poly));
+        if (!isInside(point, poly))
+        {
+            assert(leftTangent(point, view) == leftTangent(point, poly));
+            assert(fabs(distance(point, view, NULL, NULL) - distance(point, poly, NULL, NULL)) < 1e-9);
+        }
+        assert(maximalPoint(point, view) == maximalPoint(point, poly));
+    }
+    vector <Point> reversed(buffer.rbegin(), buffer.rend());
+    PolygonView(reversed.data(), (int) reversed.size(), &ok);
+    assert(!ok);
+
+    // Moved vertices are not copied, even if they are reversed
+    const Point *data = reversed.data();
+    Polygon moved(std::move(reversed));
+    assert(moved.data() == data && moved.upmost == poly.upmost && moved.downmost == poly.downmost);
+    moved.buildAngularIndex();
+    Polygon other = std::move(moved);
+    assert(other.data() == data && other.hasAngularIndex());
+    // Assignment to itself keeps vertices
+    Polygon &same = other;
+    other = std::move(same);
+    other = same;
+    assert(other.data() == data && other.size() == poly.size() && other.hasAngularIndex());
+    assert(other.view().points == data && other.view().count == poly.size());
+    PolygonView otherView = other.view();
+    assert(!memcmp(&otherView.bounds, &poly.bounds, sizeof(Bounds)));
+}
+
+void testStats()
+{
+    resetStats();
+    #ifndef GEOMETRY_STATS
+    isInside(Point(0, 0), handPolygons[0]);
+    assert(stats().functions[STATS_IS_INSIDE].calls == 0);
+    return;
+    #endif
+    Polygon poly = genLargePolygon(1000, 1 << 20);
+    const int queries = 1000;
+    for (int i = 0; i < queries; i++)
+    {
+        Point point(rand() % (1 << 22) - (1 << 21), rand() % (1 << 22) - (1 << 21));
+        isInside(point, poly);
+        isInsideBS2(point, poly);
+        maximalPoint(point, poly);
+    }
+    // Calls from other threads are counted too
+    thread other([&poly]()
+    {
+        for (int i = 0; i < queries; i++)
+            leftTangent(Point(1 << 22, i), poly);
+    });
+    other.join();
+    // Point on continuation of side of square
+    Polygon square({Point(0, 0), Point(2, 0), Point(2, 2), Point(0, 2)});
+    leftTangent(Point(4, 0), square);
+    rightTangent(Point(-4, 0), square);
+
+    Stats s = stats();
+    assert(s.functions[STATS_IS_INSIDE].calls == queries);
+    // isInsideBS2 makes two binary searches per call, both are counted in one call
+    assert(s.functions[STATS_IS_INSIDE_BS2].calls == queries);
+    assert(s.functions[STATS_IS_INSIDE_BS2].iterations > s.functions[STATS_IS_INSIDE].iterations);
+    assert(s.functions[STATS_MAXIMAL_POINT].calls == queries);
+    assert(s.functions[STATS_LEFT_TANGENT].calls == queries + 1);
+    assert(s.functions[STATS_RIGHT_TANGENT].calls == 1);
+    assert(s.functions[STATS_LEFT_TANGENT].events[STATS_COLLINEAR_SKIP] >= 1);
+    assert(s.functions[STATS_RIGHT_TANGENT].events[STATS_COLLINEAR_SKIP] >= 1);
+    assert(s.functions[STATS_DISTANCE].calls == 0);
+    for (int f = 0; f < STATS_FUNCTION_COUNT; f++)
+    {
+        const FunctionStats &function = s.functions[f];
+        unsigned long long calls = 0, iterations = 0;
+        for (int i = 0; i < statsHistogramSize; i++)
+        {
+            calls += function.histogram[i];
+            iterations += function.histogram[i] * (unsigned long long) i;
+        }
+        assert(calls == function.calls && iterations == function.iterations);
+        assert(function.predicates <= s.predicates);
+    }
+    // Binary search over 1000 vertices makes about 10 iterations
+    assert(s.functions[STATS_IS_INSIDE].iterations <= 11 * queries);
+    assert(s.functions[STATS_IS_INSIDE].predicates >= s.functions[STATS_IS_INSIDE].iterations);
+
+    FILE *f = tmpfile();
+    printStatsJson(s, f);
+    rewind(f);
+    char json[4096];
+    assert(fgets(json, sizeof(json), f));
+    fclose(f);
+    assert(strstr(json, "\"isInside\": {\"calls\": 1000,") && !strstr(json, "\"distance\""));
+
+    resetStats();
+    assert(stats().functions[STATS_IS_INSIDE].calls == 0 && stats().predicates == 0);
+}
+
+void testBounds()
+{
+    const Point dirs[8] = {Point(1, 0), Point(1, 1), Point(0, 1), Point(-1, 1), Point(-1, 0), Point(-1, -1), Point(0, -1), Point(1, -1)};
+    for (int test = 0; test < 2000; test++)
+    {
+        Polygon owner = test % 2 ? genSmallPolygon(10) : genLargePolygon(rand() % 300 + 3, 1 << 20);
+        // Bounds are found for polygon over view too
+        Polygon poly = test % 4 == 2 ? Polygon(PolygonView(owner.data(), owner.size(), owner.upmost, owner.downmost)) : owner;
+        const Bounds &b = poly.bounds;
+        for (int k = 0; k < 8; k++)
+            assert(poly[b.extremes[k]] * dirs[k] == poly[maximalPointLinear(dirs[k], poly)] * dirs[k]);
+        assert(b.maxX == poly[b.extremes[0]].x && b.maxY == poly[poly.upmost].y && b.minX == poly[b.extremes[4]].x);
+        assert(b.maxSum == poly[b.extremes[1]] * dirs[1] && b.minDiff == -(poly[b.extremes[3]] * dirs[3]));
+        int scale = max(b.maxX - b.minX, b.maxY - b.minY) + 2;
+        for (int i = 0; i < 100; i++)
+        {
+            Point point(b.minX + rand() % (3 * scale) - scale, b.minY + rand() % (3 * scale) - scale);
+            if (!b.contains(point))
+                assert(!isInsideLinear(point, poly));
+            Point other = point + Point(rand() % 5 - 2, rand() % 5 - 2);
+            if (other != point)
+            {
+                bool ok;
+                intersectionLinear(Line(point, other), poly, &ok);
+                assert(!ok || b.crosses(Line(point, other)));
+            }
+        }
+    }
+    // Queries to far points are rejected in O(1)
+    resetStats();
+    Polygon poly = genLargePolygon(1000, 1 << 20);
+    for (int i = 0; i < 100; i++)
+    {
+        Point far(rand() % (1 << 20) + (1 << 21), rand() % (1 << 22) - (1 << 21));
+        assert(!isInside(far, poly));
+        assert(eq(distance(far, poly, NULL, NULL), distanceLinear(far, poly)));
+        bool ok;
+        intersection(Line(far, far + Point(0, 1)), poly, &ok);
+        assert(!ok);
+    }
+    // Bounding boxes of square and diamond intersect, but their sums x + y do not
+    Polygon square({Point(0, 0), Point(2, 0), Point(2, 2), Point(0, 2)});
+    Polygon diamond({Point(3, 2), Point(4, 3), Point(3, 4), Point(2, 3)});
+    assert(!square.bounds.overlaps(diamond.bounds) && square.bounds.overlaps(diamond.bounds, Point(1, 1)));
+    assert(!isIntersection(square, diamond) && isIntersection(square, Polygon({Point(2, 2), Point(3, 2), Point(2, 3)})));
+    assert(isCollision(square, Point(1, 1), diamond) && !isCollision(square, Point(-1, -1), diamond));
+    #ifdef GEOMETRY_STATS
+    Stats s = stats();
+    assert(s.functions[STATS_IS_INSIDE].events[STATS_OUTSIDE_BOUNDS] == 100);
+    assert(s.functions[STATS_IS_INSIDE].iterations == 0);
+    assert(s.functions[STATS_INTERSECTION].events[STATS_OUTSIDE_BOUNDS] == 100);
+    // isInsideBS2 and queries with hint are counted too
+    resetStats();
+    for (int i = 0; i < 100; i++)
+    {
+        Point far(rand() % (1 << 20) + (1 << 21), rand() % (1 << 22) - (1 << 21));
+        int hint = i;
+        assert(!isInside(far, poly, hint) && !isInsideBS2(far, poly));
+        leftTangent(far, poly, i);
+        rightTangent(far, poly, i);
+        maximalPoint(far, poly, i);
+    }
+    s = stats();
+    for (StatsFunction f : {STATS_IS_INSIDE, STATS_IS_INSIDE_BS2})
+        assert(s.functions[f].calls == 100 && s.functions[f].events[STATS_OUTSIDE_BOUNDS] == 100);
+    for (StatsFunction f : {STATS_LEFT_TANGENT, STATS_RIGHT_TANGENT, STATS_MAXIMAL_POINT})
+        assert(s.functions[f].calls == 100);
+    #endif
+}
+
+void testExecutor()
+{
+    Polygon poly = genLatticePolygon(20, Point(rand() % (1 << 28), rand() % (1 << 28)));
+    vector <Point> points;
+    vector <Line> lines;
+    for (int i = 0; i < 3001; i++)
+    {
+        points.push_back(Point(rand() % 4000 - 2000, rand() % 4000 - 2000) + poly[0]);
+        lines.push_back(Line(poly[rand() % poly.size()], poly[rand() % poly.size()] + Point(1, 0)));
+    }
+    for (int threads = 1; threads <= 4; threads++)
+    {
+        Executor executor(threads);
+        assert(executor.threadCount() == threads);
+        vector <char> inside(points.size());
+        executor.isInside(poly, points.data(), (int) points.size(), (bool *) inside.data());
+        vector <int> maximal(points.size());
+        executor.maximalPoint(poly, points.data(), (int) points.size(), maximal.data());
+        vector <SegmentDouble> segments(lines.size());
+        vector <char> ok(lines.size());
+        executor.intersection(poly, lines.data(), (int) lines.size(), segments.data(), (bool *) ok.data());
+        for (int i = 0; i < (int) points.size(); i++)
+        {
+            assert((bool) inside[i] == isInside(points[i], poly));
+            assert(maximal[i] == maximalPoint(points[i], poly));
+            bool okLinear;
+            SegmentDouble segment = intersection(lines[i], poly, &okLinear);
+            assert((bool) ok[i] == okLinear && (!okLinear || segment == segments[i]));
+        }
+        vector <Point> outside;
+        for (int i = 0; i < (int) points.size(); i++)
+            if (!inside[i])
+                outside.push_back(points[i]);
+        vector <double> distances(outside.size());
+        vector <int> left(outside.size()), right(outside.size());
+        executor.distance(poly, outside.data(), (int) outside.size(), distances.data());
+        executor.leftTangent(poly, outside.data(), (int) outside.size(), left.data());
+        executor.rightTangent(poly, outside.data(), (int) outside.size(), right.data());
+        for (int i = 0; i < (int) outside.size(); i++)
+        {
+            assert(distances[i] == distance(outside[i], poly));
+            assert(left[i] == leftTangent(outside[i], poly));
+            assert(right[i] == rightTangent(outside[i], poly));
+        }
+    }
+}
+
+void testPolygonSet()
+{
+    vector <Polygon> polygons;
+    for (int i = 0; i < 300; i++)
+    {
+        const Polygon &poly = handPolygons[i % handPolygons.size()];
+        Point shift(rand() % 200 - 100, rand() % 200 - 100);
+        vector <Point> points;
+        for (int j = 0; j < poly.size(); j++)
+            points.push_back(poly[j] + shift);
+        polygons.push_back(Polygon(points));
+    }
+    PolygonSet set(polygons);
+    assert(set.size() == (int) polygons.size());
+    vector <Point> points;
+    for (int i = 0; i < 5000; i++)
+        points.push_back(Point(rand() % 240 - 120, rand() % 240 - 120));
+    vector <int> found(points.size()), all;
+    set.find(points.data(), (int) points.size(), found.data());
+    for (int i = 0; i < (int) points.size(); i++)
+    {
+        vector <int> expected;
+        for (int j = 0; j < (int) polygons.size(); j++)
+            if (isInsideLinear(points[i], polygons[j]))
+                expected.push_back(j);
+        set.findAll(points[i], all);
+        assert(all == expected);
+        assert(found[i] == (expected.empty() ? -1 : expected[0]));
+        assert(set.find(points[i]) == found[i]);
+    }
+    assert(PolygonSet(vector <Polygon> ()).find(Point(0, 0)) == -1);
+}
+
 void testDistance()
 {
     for (auto &test : distanceTests)
@@ -185,6 +1007,26 @@ void testDistance()
             assert(eq(distance(poly[i], poly), 0));
         }
     }
+
+    for (auto poly : handPolygons)
+        for (int indexed = 0; indexed < 2; indexed++)
+        {
+            if (indexed)
+                poly.buildAngularIndex();
+            for (int i = -10; i <= 10; i++)
+                for (int j = -10; j <= 10; j++)
+                {
+                    Point pnt(i, j);
+                    if (isInsideLinear(pnt, poly))
+                        continue;
+                    PointDouble nearest;
+                    int side;
+                    double result = distance(pnt, poly, &nearest, &side);
+                    assert(eq(result, distanceLinear(pnt, poly)) && 0 <= side && side < poly.size());
+                    assert(eq(distance(pnt, Segment(poly[side], poly[side + 1])), result));
+                    assert(eq(hypot(nearest.x - pnt.x, nearest.y - pnt.y), result));
+                }
+        }
 }
 
 void testMaximalPoint()
@@ -225,12 +1067,315 @@ void testIntersection()
     }    
 }
 
-int main()
+// Differential test of fast queries against their linear versions. Query space is split
+// into blocks of differentialBlock queries to one random polygon. Block i uses its own
+// generator seeded with seed and i, so failure is reproduced by seed regardless of the
+// number of threads, and threads take blocks one by one.
+// Coordinates of polygons are below 2^28 and ones of points below 2^29, so that
+// coefficients of lines through points and their values at vertices do not overflow
+
+const int differentialBlock = 1 << 12;
+const int differentialLimit = (1 << 29) - 1;
+
+int clampCoord(long long a)
+{
+    return (int) max((long long) -differentialLimit, min((long long) differentialLimit, a));
+}
+
+long long uniform(mt19937_64 &random, long long from, long long to)
+{
+    return from + (long long) (random() % (unsigned long long) (to - from + 1));
+}
+
+// Returns vertices of random polygon and sets center and scale of region of queries
+vector <Point> genDifferentialPolygon(mt19937_64 &random, Point &center, int &scale)
+{
+    vector <Point> result;
+    center = Point(0, 0);
+    switch (random() % 4)
+    {
+        case 0:
+        {
+            const Polygon &poly = handPolygons[random() % handPolygons.size()];
+            result.assign(poly.data(), poly.data() + poly.size());
+            scale = 25;
+            break;
+        }
+        case 1:
+        {
+            scale = 1 << (random() % 28);
+            bool ok = 0;
+            while (!ok)
+            {
+                vector <Point> points((size_t) uniform(random, 3, 10));
+                for (auto &p : points)
+                    p = Point((int) uniform(random, -scale, scale), (int) uniform(random, -scale, scale));
+                Polygon poly = convexHull(points, &ok);
+                result.assign(poly.data(), poly.data() + poly.size());
+            }
+            break;
+        }
+        case 2:
+        {
+            int side = (int) uniform(random, 2, 8);
+            center = Point((int) uniform(random, -(1 << 27), 1 << 27), (int) uniform(random, -(1 << 27), 1 << 27));
+            Polygon poly = genLatticePolygon(side, center);
+            result.assign(poly.data(), poly.data() + poly.size());
+            scale = side * side * side;
+            break;
+        }
+        default:
+        {
+            int n = (int) uniform(random, 3, 3 + (1 << (random() % 8)));
+            scale = max(1 << (random() % 18 + 10), 4 * n * n);
+            Polygon poly = genLargePolygon(n, scale, random());
+            result.assign(poly.data(), poly.data() + poly.size());
+            break;
+        }
+    }
+    return result;
+}
+
+// Random point inside region of queries, near a vertex or on continuation of a side
+Point genDifferentialPoint(mt19937_64 &random, const vector <Point> &poly, const Point &center, int scale)
+{
+    const Point &vertex = poly[random() % poly.size()];
+    switch (random() % 3)
+    {
+        case 0:
+            return Point(clampCoord(center.x + uniform(random, -2ll * scale, 2ll * scale)),
+                         clampCoord(center.y + uniform(random, -2ll * scale, 2ll * scale)));
+        case 1:
+            return Point(clampCoord(vertex.x + uniform(random, -2, 2)), clampCoord(vertex.y + uniform(random, -2, 2)));
+        default:
+        {
+            const Point &next = poly[(size_t) (&vertex - poly.data() + 1) % poly.size()];
+            long long t = uniform(random, -2, 3);
+            return Point(clampCoord(vertex.x + t * (next.x - vertex.x)), clampCoord(vertex.y + t * (next.y - vertex.y)));
+        }
+    }
+}
+
+// Returns name of the first query on which fast and linear versions disagree, or NULL
+const char* differentialMismatch(const Polygon &poly, const Point &a, const Point &b)
+{
+    bool inside = isInsideLinear(a, poly);
+    if (isInside(a, poly) != inside)
+        return "isInside";
+    if (isInsideBS2(a, poly) != inside)
+        return "isInsideBS2";
+    int hint = (a.x ^ a.y) & 1023;
+    if (isInside(a, poly, hint) != inside)
+        return "isInside with hint";
+    if (!inside)
+    {
+        Point left = poly[leftTangentLinear(a, poly)], right = poly[rightTangentLinear(a, poly)];
+        if (poly[leftTangent(a, poly)] != left)
+            return "leftTangent";
+        if (poly[leftTangent(a, poly, hint)] != left)
+            return "leftTangent with hint";
+        if (poly[rightTangent(a, poly)] != right)
+            return "rightTangent";
+        if (poly[rightTangent(a, poly, hint)] != right)
+            return "rightTangent with hint";
+        if (!eq(distance(a, poly, NULL, NULL), distanceLinear(a, poly)))
+            return "distance";
+    }
+    if (a != Point(0, 0))
+    {
+        long long maximal = poly[maximalPointLinear(a, poly)] * a, minimal = poly[minimalPointLinear(a, poly)] * a;
+        if (poly[maximalPoint(a, poly)] * a != maximal)
+            return "maximalPoint";
+        if (poly[maximalPoint(a, poly, hint)] * a != maximal)
+            return "maximalPoint with hint";
+        if (poly[minimalPoint(a, poly)] * a != minimal)
+            return "minimalPoint";
+        if (poly[minimalPoint(a, poly, hint)] * a != minimal)
+            return "minimalPoint with hint";
+    }
+    bool ok1, ok2;
+    SegmentDouble fast = intersection(Line(a, b), poly, &ok1), linear = intersectionLinear(Line(a, b), poly, &ok2);
+    // Ends can be found in different order and with different rounding errors
+    auto same = [](const PointDouble &first, const PointDouble &second)
+    {
+        return eq(first.x, second.x) && eq(first.y, second.y);
+    };
+    if (ok1 != ok2 || (ok1 && !(same(fast.first, linear.first) && same(fast.second, linear.second)) &&
+                              !(same(fast.first, linear.second) && same(fast.second, linear.first))))
+        return "intersection";
+    return NULL;
+}
+
+// Fast queries are checked with and without angular index. Linear ones are faster
+// with separate arrays
+Polygon differentialPolygon(const vector <Point> &vertices, bool indexed)
+{
+    Polygon poly(vertices);
+    if (indexed)
+        poly.buildAngularIndex();
+    poly.buildSoA();
+    return poly;
+}
+
+// Greedily makes failing case smaller: removes vertices and moves vertices and points
+// towards origin while case stays valid and failing
+void shrinkDifferential(vector <Point> &poly, Point &a, Point &b, bool indexed)
+{
+    auto fails = [indexed](const vector <Point> &p, const Point &first, const Point &second)
+    {
+        return isStrictlyConvex(p.data(), (int) p.size()) && first != second &&
+               differentialMismatch(differentialPolygon(p, indexed), first, second);
+    };
+    auto closer = [](const Point &p, int k)
+    {
+        if (k == 0)
+            return Point(p.x / 2, p.y / 2);
+        if (k == 1)
+            return Point(p.x - (p.x > 0) + (p.x < 0), p.y);
+        return Point(p.x, p.y - (p.y > 0) + (p.y < 0));
+    };
+    for (bool changed = 1; changed; )
+    {
+        changed = 0;
+        for (int i = 0; i < (int) poly.size() && poly.size() > 3; i++)
+        {
+            vector <Point> smaller = poly;
+            smaller.erase(smaller.begin() + i);
+            if (fails(smaller, a, b))
+            {
+                poly = smaller;
+                changed = 1;
+                i--;
+            }
+        }
+        // Moves the whole case, then every vertex and point alone
+        for (int k = 0; k < 3; k++)
+        {
+            vector <Point> moved = poly;
+            for (auto &p : moved)
+                p = closer(p, k);
+            if (fails(moved, closer(a, k), closer(b, k)))
+            {
+                poly = moved;
+                a = closer(a, k);
+                b = closer(b, k);
+                changed = 1;
+            }
+            for (auto &p : poly)
+            {
+                Point old = p;
+                p = closer(p, k);
+                if (p != old && fails(poly, a, b))
+                    changed = 1;
+                else
+                    p = old;
+            }
+            if (closer(a, k) != a && fails(poly, closer(a, k), b))
+            {
+                a = closer(a, k);
+                changed = 1;
+            }
+            if (closer(b, k) != b && fails(poly, a, closer(b, k)))
+            {
+                b = closer(b, k);
+                changed = 1;
+            }
+        }
+    }
+}
+
+// Checks blocks * differentialBlock queries with all processors. Returns false and
+// prints shrunk failing case if versions disagree
+bool runDifferential(unsigned long long seed, long long blocks)
 {
-    srand(time(NULL));    
-    isInsideBS1(Point(1, 2), handPolygons[0]);
+    atomic <long long> next(0);
+    // The first failing block, so that failure does not depend on scheduling
+    long long failed = blocks;
+    mutex failedLock;
+    auto work = [&]()
+    {
+        for (long long block; (block = next++) < blocks; )
+        {
+            {
+                lock_guard <mutex> guard(failedLock);
+                if (block > failed)
+                    return;
+            }
+            mt19937_64 random(seed * 0x9E3779B97F4A7C15ull + (unsigned long long) block);
+            Point center;
+            int scale;
+            vector <Point> vertices = genDifferentialPolygon(random, center, scale);
+            Polygon poly = differentialPolygon(vertices, block % 2);
+            for (int i = 0; i < differentialBlock; i++)
+            {
+                Point a = genDifferentialPoint(random, vertices, center, scale), b = a;
+                while (b == a)
+                    b = genDifferentialPoint(random, vertices, center, scale);
+                if (differentialMismatch(poly, a, b))
+                {
+                    lock_guard <mutex> guard(failedLock);
+                    failed = min(failed, block);
+                    return;
+                }
+            }
+        }
+    };
+    vector <thread> threads(max(1u, thread::hardware_concurrency()) - 1);
+    for (auto &t : threads)
+        t = thread(work);
+    work();
+    for (auto &t : threads)
+        t.join();
+    if (failed == blocks)
+        return 1;
+
+    // Replays the failing block to find the case
+    mt19937_64 random(seed * 0x9E3779B97F4A7C15ull + (unsigned long long) failed);
+    Point center, a, b;
+    int scale;
+    vector <Point> vertices = genDifferentialPolygon(random, center, scale);
+    Polygon poly = differentialPolygon(vertices, failed % 2);
+    do
+    {
+        a = genDifferentialPoint(random, vertices, center, scale), b = a;
+        while (b == a)
+            b = genDifferentialPoint(random, vertices, center, scale);
+    }
+    while (!differentialMismatch(poly, a, b));
+    cerr << "Differential test failed, seed " << seed << ", block " << failed << endl;
+    shrinkDifferential(vertices, a, b, failed % 2);
+    cerr << differentialMismatch(differentialPolygon(vertices, failed % 2), a, b) << " differs for polygon " << Polygon(vertices)
+         << endl << "and points " << a << " " << b << endl;
     return 0;
+}
+
+// Usage: test.exe [seed [queries]]
+// If number of queries is given, then only differential test runs with them
+int main(int argc, char **argv)
+{
+    unsigned long long seed = argc > 1 ? strtoull(argv[1], NULL, 10) : 1;
+    srand((unsigned) seed);
+    if (argc > 2)
+        return runDifferential(seed, (atoll(argv[2]) + differentialBlock - 1) / differentialBlock) ? 0 : 1;
+    testPredicates();
     testIsInside();
+    testIsInsideBatch();
+    testAngularIndex();
+    testSoA();
+    testGenLargePolygon();
+    testExecutor();
+    testConvexHull();
+    testPolygonIntersection();
+    testMinkowski();
+    testPolygonDistance();
+    testBasicGeometry();
+    testPolygonFile();
+    testHints();
+    testPolygonView();
+    testStats();
+    testBounds();
+    testRotatingCalipers();
+    testPolygonSet();
     testDistance();
     testMaximalPoint();
     testLeftTangent();
@@ -239,76 +1384,5 @@ int main()
     assert(isIntersection(Line(Point(0, 0), Point(1, 1)), Segment(Point(0, 0), Point(0, 1))));
     assert(isIntersection(Line(Point(0, 0), Point(1, 1)), Segment(Point(0, 0), Point(1, 1))));
     assert(!isIntersection(Line(Point(0, 0), Point(1, -1)), Segment(Point(2, 2), Point(1, 1))));
-    for (int i = -50; i <= 50; i++)
-        for (int j = -50; j <= 50; j++)
-        {
-            for (auto &poly : handPolygons)
-            {                                        
-                Point pnt = Point(i, j);
-                if (pnt != Point(0, 0))
-                {                
-                    assert(poly[minimalPoint(pnt, poly)] * pnt == poly[minimalPointLinear(pnt, poly)] * pnt);
-                    assert(poly[maximalPoint(pnt, poly)] * pnt == poly[maximalPointLinear(pnt, poly)] * pnt);
-                }
-                bool resultLinear = isInsideLinear(pnt, poly);
-                bool resultBS1 = isInsideBS1(pnt, poly);
-                bool resultBS2 = isInsideBS2(pnt, poly);
-                //cerr << i << " " << j << " " << resultLinear << " " << resultBS1 << " " << resultBS2 << endl;
-                assert(resultLinear == resultBS1 && resultBS1 == resultBS2);
-                if (!resultLinear)
-                {
-                    assert(poly[leftTangentLinear(pnt, poly)] == poly[leftTangent(pnt, poly)]);
-                    assert(poly[rightTangentLinear(pnt, poly)] == poly[rightTangent(pnt, poly)]);
-                    assert(abs(distanceLinear(pnt, poly) - distance(pnt, poly)) < 1e-5);
-                }
-            }
-        
-        } 
-                          
-    for (auto &poly : handPolygons)
-        for (int a = -25; a <= 25; a++)
-            for (int b = -25; b <= 25; b++)
-                for (int c = -25; c <= 25; c++)
-                    for (int d = -25; d <= 25; d++)
-                    {
-                        if (a == c && b == d)
-                            continue;
-                        bool ok1 = 0, ok2 = 0;
-                        SegmentDouble x, y;
-                        x = intersection(Line(Point(a, b), Point(c, d)), poly, &ok1);
-                        y = intersectionLinear(Line(Point(a, b), Point(c, d)), poly, &ok2);
-                        if (ok1 != ok2)
-                            cerr << Point(a, b) << " " << Point(c, d) << " " << poly << endl << x << " " << y << " " << ok1 << " " << ok2 << endl;
-                        assert(ok1 == ok2);
-                        if (ok1)
-                            if (!(x == y))
-                            {
-                                cerr << Point(a, b) << " " << Point(c, d) << " " << x << " " << y << endl << poly << endl;
-                                return 0;
-                            }
-                            assert(x == y);
-                    } 
-    Polygon poly = genLargePolygon(50);
-    for (int i = 0; i < 3000; i++)
-    {
-        int x = rand() % 10 + 5;
-        Point pnt(rand() % (1<<(x + 1)) - (1<<x), rand() - (1<<x));
-        bool in1 = isInsideLinear(pnt, poly), in2 = isInsideBS1(pnt, poly), in3 = isInsideBS2(pnt, poly);
-        if (pnt != Point(0, 0))
-        {
-            assert(poly[minimalPoint(pnt, poly)] * pnt == poly[minimalPointLinear(pnt, poly)] * pnt);
-            assert(poly[maximalPoint(pnt, poly)] * pnt == poly[maximalPointLinear(pnt, poly)] * pnt);
-        }
-        Point pnt1(rand() % (1<<15) - (1<<14), rand() % (1<<15) - (1<<14));
-        if (pnt1 != pnt)
-            assert(intersection(Line(pnt, pnt1), poly) == intersectionLinear(Line(pnt, pnt1), poly));
-        assert(in1 == in2 && in2 == in3);
-        if (!in1)
-        {
-            assert(poly[leftTangentLinear(pnt, poly)] == poly[leftTangent(pnt, poly)]);
-            assert(poly[rightTangentLinear(pnt, poly)] == poly[rightTangent(pnt, poly)]);
-            assert(abs(distanceLinear(pnt, poly) - distance(pnt, poly)) < 1e-5);
-            
-        }
-    }                       
+    assert(runDifferential(seed, 512));
 }
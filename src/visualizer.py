@@ -9,6 +9,9 @@ import matplotlib.patches as patches
 
 EPS = 10 ** -6
 
+# Polygons declared in trace, state commands refer to them by index
+polygons = []
+
 def getOptions(args):
     d = dict(tuple(x.split('=')) for x in args)
     if 'name' in d:
@@ -83,6 +86,22 @@ def drawAngle(angle):
     
     plt.gca().add_patch(patches.Arc((coords[0], coords[1]), length, length, theta1=angle1, theta2=angle2))
 
+def drawState(state):
+    args = list(map(int, state.split()))
+    poly, l, m, r = polygons[args[0]], args[1], args[2], args[3]
+    n = len(poly)
+    for index, name in ((l, 'l'), (r, 'r'), (m, 'm')):
+        if index != -1:
+            x, y = poly[index % n]
+            drawPoint('{0} {1} name={2}'.format(x, y, name))
+    xs = [p[0] for p in poly] + [poly[0][0]]
+    ys = [p[1] for p in poly] + [poly[0][1]]
+    plt.plot(xs, ys, '-', lw=1.5, color='black')
+    first, last = max(l, 0), min(r, n)
+    if first < last:
+        plt.plot(xs[first:last + 1], ys[first:last + 1], '-', lw=1.5, color='red')
+    plt.plot(xs[:-1], ys[:-1], 'o', color='black')
+
 def getCommands(fname):
     steps = [[[]]]
     inF = open(fname, 'r', encoding='utf-8')
@@ -96,6 +115,11 @@ def getCommands(fname):
             steps.append([[]])
         elif cmd == 'wait':
             steps[-1].append([])
+        elif cmd.startswith('polygon '):
+            coords = list(map(int, cmd.split()[2:]))
+            polygons.append(list(zip(coords[::2], coords[1::2])))
+        elif cmd.startswith('state '):
+            steps[-1][-1].append('state {0} {1}'.format(len(polygons) - 1, cmd[6:]))
         else:
             steps[-1][-1].append(cmd)
     if len(steps[-1][-1]) == 0:
@@ -113,7 +137,7 @@ class Visualizer:
         self.commands = commands
         self.text = None
         self.draw = {'point' : drawPoint, 'segment' : drawSegment, 'line' : drawLine, 
-                     'ray' : drawRay, 'vector' : drawVector, 'angle' : drawAngle}
+                     'ray' : drawRay, 'vector' : drawVector, 'angle' : drawAngle, 'state' : drawState}
         self.nextStep()
 
     def getStepCount(self):